@@ -5,24 +5,26 @@
 #include <random>
 #include "gene.h"
 #include "cells.h"
+#include "random.h"
+#include "grid.h"
+#include "food_index.h"
+#include "food_field.h"
+#include "agent_store.h"
 
 using namespace std;
 
 /**
  * @brief Класс - агент.
- * 
+ *
  * Содержит методы для управления агентом.
  * Агент знает свои координаты (вне поля), энергию, ген, количество шагов, состояние и собственное окружение. (Вектор направления к еде промежуточный параметр)
+ * Сам агент - это дескриптор (хранилище + номер), данные лежат в параллельных массивах AgentStore.
+ * Дескриптор дешево копируется и остается валидным, пока агент с этим номером есть в хранилище.
  */
 class Agent {
 private:
-    unique_ptr<Gene> gene;           // Уникальный указатель на ген (нейросеть)
-    vector<Cell> surroundings;       // 4 окружающих клеток
-    int energy;                      // Количество энергии
-    int steps;                       // Количество шагов
-    pair<int, int> directionToFood;  // Вектор направления к ближайшей еде
-    int x, y;                        // Координаты положения
-    bool isAlive;                    // Состояние агента
+    AgentStore* store; // Хранилище популяции
+    int index;         // Номер агента в хранилище
 
     /**
      * @brief Изменяет энергию агента на указанное количество.
@@ -34,39 +36,49 @@ private:
      * @brief Агент делает свой ход.
      * @return true если перемещение или бездействие успешно, иначе false.
      */
-    bool move(int dx, int dy, const vector<vector<Cell>>& grid);
+    bool move(int dx, int dy, const Grid& grid);
 
     /**
-     * 
+     * @brief Запоминает направление (четверть) к еде в указанной клетке.
      */
-    void initializeBrain();
+    void setDirectionTo(int foodX, int foodY);
 
 public:
-    Agent();
-    Agent(int x, int y, int energy, unique_ptr<Gene> gene = nullptr);
-    ~Agent();
-    
+    Agent(AgentStore* store, int index) : store(store), index(index) {}
+
+    /**
+     * @brief Возвращает номер агента в хранилище.
+     */
+    int getIndex() const { return index; }
+
     /**
-     * @brief Сканирует и запоминает состояние 8 окружающих клеток.
+     * @brief Сканирует и запоминает состояние 4 окружающих клеток.
      * @param grid Поле, в котором агент осматривается.
      */
-    void lookAround(vector<vector<Cell>>* grid);
+    void lookAround(const Grid& grid);
 
     /**
      * @brief Принимает решение о действии на основе входных данных, используя нейросеть.
      * @return true если ход выполнен успешно, иначе false.
      */
-    bool decideAction(const vector<vector<Cell>>& grid);
+    bool decideAction(const Grid& grid);
+
+    /**
+     * @brief Выполняет уже принятое решение (например, из пакетного вывода).
+     * @param direction Направление хода, (0, 0) - случайное движение.
+     * @return true если ход выполнен успешно, иначе false.
+     */
+    bool act(pair<int, int> direction, const Grid& grid);
 
     /**
      * @brief Агенту капут.
      */
-    void die();
+    void die() { store->alive[index] = 0; }
 
     /**
      * @brief Увеличивает кол-во шагов.
      */
-    void stepTick();
+    void stepTick() { store->steps[index]++; }
 
     /**
      * @brief Мутация гена.
@@ -78,82 +90,117 @@ public:
      * @brief Скрещивает гены агента со вторым.
      * @param other Пара для скрещивания.
      */
-    void crossing(Agent& other);
+    void crossing(Agent other);
 
     /**
-     * @brief Клонирует агента.
-     * @return Указатель на нового агента.
+     * @brief Клонирует агента в указанное хранилище.
+     * @param target Хранилище для копии.
+     * @param rng Поток случайных чисел для копии.
+     * @return Дескриптор нового агента.
      */
-    unique_ptr<Agent> clone();
+    Agent clone(AgentStore& target, Random rng) const;
 
     /**
      * @brief Возвращает текущее положение по x.
      * @return Координату x.
      */
-    int getX() const { return x; }
+    int getX() const { return store->x[index]; }
 
     /**
      * @brief Возвращает текущее положение по y.
      * @return Координату y.
      */
-    int getY() const { return y; }
+    int getY() const { return store->y[index]; }
 
     /**
      * @brief Задает новое положение по x.
      * @param newX Новое положение по x.
      */
-    void setX(int newX) { x = newX; }
+    void setX(int newX) { store->x[index] = newX; }
 
     /**
      * @brief Задает новое положение по y.
      * @param newY Новое положение по y.
      */
-    void setY(int newY) { y = newY; }
+    void setY(int newY) { store->y[index] = newY; }
 
     /**
      * @brief Возвращает текущее кол-во энергии.
      * @return Кол-во энергии.
      */
-    int getEnergy() const { return energy; }
+    int getEnergy() const { return store->energy[index]; }
 
     /**
      * @brief Задает кол-во энергии.
      * @param newEnergy Кол-во задаваемой энергии.
      */
-    void setEnergy(int newEnergy) { energy = newEnergy; }
+    void setEnergy(int newEnergy) { store->energy[index] = newEnergy; }
 
     /**
      * @brief Возвращает кол-во шагов.
      * @return Кол-во шагов.
      */
-    int getSteps() const { return steps; }
-    
-    void setSteps(int _steps) { steps = _steps; }
+    int getSteps() const { return store->steps[index]; }
+
+    void setSteps(int _steps) { store->steps[index] = _steps; }
 
     /**
      * @brief Возвращает состояние агента.
      * @return true жив, иначе false.
      */
-    bool getIsAlive() const { return isAlive; }
+    bool getIsAlive() const { return store->alive[index]; }
 
     /**
      * @brief Возвращает ссылку на ген агента.
+     *
+     * После изменения гена по этой ссылке нужно вызвать AgentStore::markGenesChanged().
      */
-    Gene& getGene() { return *gene; }
+    Gene& getGene() { return store->gene(index); }
+    const Gene& getGene() const { return store->gene(index); }
 
-    void setIsAlive(bool alive) { isAlive = alive; }
+    /**
+     * @brief Заменяет ген агента.
+     * @param newGene Новый ген.
+     */
+    void setGene(unique_ptr<Gene> newGene) {
+        store->genes[store->geneIndex[index]] = std::move(newGene);
+        store->markGenesChanged();
+    }
+
+    void setIsAlive(bool alive) { store->alive[index] = alive; }
 
     /**
-     * @brief Возвращает массив окружающих клеток.
-     * @return Массив клеток.
+     * @brief Возвращает окружающие клетки.
+     * @return Указатель на 4 клетки (вверх, влево, вправо, вниз).
      */
-    const vector<Cell>& getSurroundings() const { return surroundings; }
+    const Cell* getSurroundings() const { return &store->surroundings[index * 4]; }
 
     /**
      * @brief Возвращает направление к ближайшей еде.
+     * @param food Индекс еды на поле.
+     * @return Вектор направления.
+     */
+    pair<int, int> getDirectionToFood(const FoodIndex& food);
+
+    /**
+     * @brief Возвращает направление к ближайшей достижимой еде из поля расстояний.
+     * @param field Поле расстояний, построенное на текущем тике.
      * @return Вектор направления.
      */
-    const pair<int, int>& getDirectionToFood(vector<vector<Cell>>* grid);
+    pair<int, int> getDirectionToFood(const FoodField& field);
+
+    /**
+     * @brief Возвращает расстояние до ближайшей еды, найденной последним поиском.
+     */
+    int getDistanceToFood() const { return store->distanceToFood[index]; }
+
+    bool randomMovement(const Grid& grid);
+};
+
+inline Agent AgentStore::operator[](int i) {
+    return Agent(this, i);
+}
 
-    bool randomMovement(const vector<vector<Cell>>& grid);
-};
\ No newline at end of file
+inline const Agent AgentStore::operator[](int i) const {
+    return Agent(const_cast<AgentStore*>(this), i); // Константный дескриптор дает только чтение
+}
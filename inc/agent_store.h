@@ -0,0 +1,95 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "gene.h"
+#include "cells.h"
+#include "random.h"
+
+using namespace std;
+
+class Agent;
+
+/**
+ * @brief Хранилище популяции в виде параллельных массивов (structure of arrays).
+ *
+ * Агент - это номер в массивах, а не отдельный объект в куче. Проходы по всей популяции
+ * (перемешивание, проверка голода, отметка на поле) читают плотные массивы координат и энергии.
+ * Гены лежат в отдельном массиве и адресуются через geneIndex, поэтому перестановка агентов
+ * не двигает сами гены. Прежний интерфейс агента доступен через легкий дескриптор Agent (см. agent_logic.h).
+ * Очистка хранилища не удаляет гены, а откладывает их: addCopy переписывает отложенный ген
+ * по образцу (Gene::assign), поэтому заполнение хранилища заново не выделяет память.
+ */
+struct AgentStore {
+    vector<int> x, y;                        // Координаты положения
+    vector<int> energy;                      // Количество энергии
+    vector<int> steps;                       // Количество шагов
+    vector<uint8_t> alive;                   // Состояние агента (1 - жив)
+    vector<int> geneIndex;                   // Номер гена агента в genes
+    vector<Random> rng;                      // Собственные потоки случайных чисел
+    vector<Cell> surroundings;               // По 4 окружающих клетки на агента
+    vector<pair<int, int>> directionToFood;  // Вектор направления к ближайшей еде
+    vector<int> distanceToFood;              // Расстояние до ближайшей еды (-1 - еды нет)
+    vector<unique_ptr<Gene>> genes;          // Гены (нейросети)
+    vector<unique_ptr<Gene>> spareGenes;     // Гены прежних агентов для повторного использования
+    vector<uint8_t> permuted;                // Рабочий массив перестановки (отметки пройденных агентов)
+    uint64_t genesVersion = 0;               // Версия набора генов (меняется при любом изменении генов)
+
+    /**
+     * @brief Возвращает кол-во агентов.
+     */
+    int size() const { return x.size(); }
+
+    bool empty() const { return x.empty(); }
+
+    /**
+     * @brief Резервирует место под указанное кол-во агентов.
+     */
+    void reserve(int count);
+
+    /**
+     * @brief Удаляет всех агентов, их гены откладываются для повторного использования.
+     */
+    void clear();
+
+    /**
+     * @brief Добавляет агента.
+     * @param gene Ген агента (nullptr - случайная нейросеть).
+     * @return Номер нового агента.
+     */
+    int add(int x, int y, int energy, unique_ptr<Gene> gene, Random rng);
+
+    /**
+     * @brief Добавляет агента с копией гена (отложенный ген переписывается по образцу, иначе clone()).
+     * @param source Образец гена.
+     * @return Номер нового агента.
+     */
+    int addCopy(int x, int y, int energy, const Gene& source, Random rng);
+
+    /**
+     * @brief Переставляет агентов на месте: новый i-й агент - это прежний order[i]-й.
+     * @param order Перестановка номеров агентов.
+     */
+    void permute(const vector<int>& order);
+
+    /**
+     * @brief Отмечает, что гены изменились (новый ген, мутация, скрещивание).
+     *
+     * Версии выдаются из общего счетчика, поэтому не повторяются и между разными хранилищами.
+     * Кэши, построенные по генам (пакетный вывод), сравнивают версию и перестраиваются.
+     */
+    void markGenesChanged();
+
+    /**
+     * @brief Возвращает ген агента.
+     */
+    Gene& gene(int i) { return *genes[geneIndex[i]]; }
+    const Gene& gene(int i) const { return *genes[geneIndex[i]]; }
+
+    /**
+     * @brief Возвращает дескриптор агента (определено в agent_logic.h).
+     */
+    Agent operator[](int i);
+    const Agent operator[](int i) const;
+};
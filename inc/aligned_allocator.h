@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Аллокатор для vector с выравниванием начала буфера (для SIMD-загрузок).
+ * @tparam T Тип элемента.
+ * @tparam Alignment Выравнивание в байтах.
+ */
+template <class T, size_t Alignment = 32>
+struct AlignedAllocator {
+    using value_type = T;
+
+    template <class U>
+    struct rebind { using other = AlignedAllocator<U, Alignment>; };
+
+    AlignedAllocator() = default;
+
+    template <class U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+    T* allocate(size_t count) {
+        return static_cast<T*>(::operator new(count * sizeof(T), align_val_t(Alignment)));
+    }
+
+    void deallocate(T* pointer, size_t) {
+        ::operator delete(pointer, align_val_t(Alignment));
+    }
+
+    template <class U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+
+    template <class U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+};
+
+/**
+ * @brief Выровненный по 32 байта массив чисел (ширина регистра AVX).
+ */
+using AlignedFloats = vector<float, AlignedAllocator<float, 32>>;
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @brief Счетчик выделений памяти для проверки путей без аллокаций.
+ *
+ * Считает только при сборке с COUNT_ALLOCATIONS (CMake: -DCOUNT_ALLOCATIONS=ON):
+ * тогда глобальные operator new/delete заменяются обертками над malloc/free со счетчиком.
+ * В обычной сборке замены нет и счетчик всегда 0.
+ */
+
+/**
+ * @brief Возвращает true, если программа собрана со счетчиком выделений.
+ */
+bool allocationCountingEnabled();
+
+/**
+ * @brief Возвращает кол-во вызовов operator new с начала работы (во всех потоках).
+ */
+uint64_t getAllocationCount();
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include "agent_store.h"
+#include "neural_network.h"
+
+using namespace std;
+
+/**
+ * @brief Пакетный вывод нейросетей всей популяции за один тик.
+ *
+ * Веса всех генов складываются в общий тензор: для каждого слоя - блоки [ген][выход][stride]
+ * в той же выровненной раскладке, что и в GeneLayer, и [ген][выход] для смещений.
+ * Каждая строка пакета считается тем же ядром denseForward, что и одиночный вывод.
+ * Входы живых агентов собираются в одну матрицу [агент][вход] и прогоняются слой за слоем,
+ * решения (argmax выходов) раскладываются обратно по номерам агентов.
+ * Тензор перестраивается только при смене версии генов хранилища (AgentStore::genesVersion).
+ */
+class BatchedInference {
+private:
+    bool built;                       // Тензор построен
+    bool compatible;                  // Все гены - полносвязные сети одной топологии (см. Gene::getLayer)
+    uint64_t builtVersion;            // Версия генов, по которой построен тензор
+    vector<int> sizes;                // Размеры слоев: вход, скрытые, выход
+    vector<int> strides;              // Шаг строки весов каждого слоя
+    vector<Activation> activations;   // Активация каждого слоя
+    vector<AlignedFloats> weights;    // Веса слоев: [ген][выход][stride]
+    vector<vector<float>> biases;     // Смещения слоев: [ген][выход]
+    vector<int> rows;                 // Номера агентов в пакете
+    vector<float> current, next;      // Активации пакета [агент][нейрон]
+
+    /**
+     * @brief Складывает веса всех генов в тензор.
+     * @return false если гены нельзя обработать одним пакетом.
+     */
+    bool build(const AgentStore& store);
+
+public:
+    BatchedInference();
+
+    /**
+     * @brief Готовит тензор весов под текущие гены (перестраивает при изменении генов).
+     * @return true если пакетный вывод возможен.
+     */
+    bool prepare(const AgentStore& store);
+
+    /**
+     * @brief Принимает решения для всех живых агентов.
+     *
+     * Окружение и направление к еде агентов уже должны быть собраны на этом тике.
+     * @param store Популяция.
+     * @param decisions Направления хода по номерам агентов (размер меняется под популяцию).
+     */
+    void decide(const AgentStore& store, vector<pair<int, int>>& decisions);
+};
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+class EvolutionSimulation;
+
+/*
+ * Контрольная точка обучения (версия 1) - снимок всего состояния EvolutionSimulation.
+ * Все числа - little-endian, все разделы выровнены по 32 байта и дополнены нулями.
+ *
+ *   Заголовок (128 байт): "AGCP", версия, размер файла, контрольная сумма FNV-1a (64 бита)
+ *                         всех байтов после заголовка, зерно запуска, номер потока симуляции,
+ *                         размеры поля со стенами, кол-во агентов, значений еды и пустых клеток,
+ *                         поколение, коэффициент мутации, счетчики смертей, живых и тиков,
+ *                         положение в цикле обучения, состояние генератора симуляции.
+ *   Поле: типы клеток (по байту), ценность еды (int32), пустые клетки в текущем порядке (int32).
+ *   Значения еды начала раунда (int32).
+ *   Агенты по столбцам: x, y, энергия, шаги (int32), признак жизни (байт), генераторы (по 11 uint32).
+ *   Гены агентов по порядку - записи в формате архива геномов (см. genome_file.h).
+ *
+ * Сохраняется все, от чего зависит дальнейший ход обучения, в том числе порядок списка пустых
+ * клеток и состояния всех генераторов, поэтому продолженное обучение совпадает с непрерывным.
+ * Производные структуры (индекс еды, статистика энергии) при загрузке собираются заново.
+ */
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "Checkpoints are read by mapping little-endian data directly"
+#endif
+
+/**
+ * @brief Записывает файл атомарно: во временный файл рядом, затем переименованием поверх старого.
+ *
+ * Прерванная запись не портит прежнюю версию файла: читатель видит либо старый файл, либо новый целиком.
+ * @return true если файл записан и переименован.
+ */
+bool writeFileAtomically(const string& path, const vector<unsigned char>& bytes);
+
+/**
+ * @brief Сохраняет контрольные точки обучения, при необходимости в фоновом потоке.
+ *
+ * Снимок собирается в памяти вызывающим потоком (это копирование массивов, доли миллисекунды),
+ * а запись на диск уходит фоновому потоку, поэтому обучение не ждет диска. Если предыдущий
+ * снимок еще не записан, он заменяется новым. Буферы снимков переиспользуются между вызовами.
+ */
+class CheckpointWriter {
+private:
+    string path;                     // Файл контрольной точки
+    bool background;                 // Запись в фоновом потоке
+    vector<unsigned char> staging;   // Снимок, собираемый вызывающим потоком
+    vector<unsigned char> pending;   // Снимок, ожидающий записи
+    vector<unsigned char> writing;   // Снимок, записываемый фоновым потоком
+    bool hasPending;                 // pending ждет записи
+    bool busy;                       // Фоновый поток пишет writing
+    bool stopping;                   // Фоновый поток должен завершиться
+    int failures;                    // Кол-во неудачных записей
+    mutex lock;
+    condition_variable changed;
+    thread worker;                   // Запускается при первом сохранении в фоне
+
+    void run();
+
+public:
+    /**
+     * @param path Файл контрольной точки.
+     * @param background Писать файл в фоновом потоке.
+     */
+    CheckpointWriter(const string& path, bool background);
+
+    /**
+     * @brief Дожидается записи последнего снимка.
+     */
+    ~CheckpointWriter();
+
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+    /**
+     * @brief Сохраняет снимок симуляции.
+     * @param loopPosition Положение в цикле обучения (см. EvolutionSimulation::saveSnapshot).
+     * @return false если снимок не собрался или (без фонового потока) не записался.
+     */
+    bool save(const EvolutionSimulation& sim, int loopPosition = 0);
+
+    /**
+     * @brief Дожидается записи всех отданных снимков.
+     */
+    void flush();
+
+    /**
+     * @brief Возвращает кол-во неудачных записей.
+     */
+    int getFailureCount();
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+
+using namespace std;
+
+/**
+ * @brief Задает параметр запуска по имени.
+ *
+ * Имена совпадают с флагами командной строки без "--" (например, "field-width", "mutation-power").
+ * Целые значения должны быть записаны целиком и помещаться в тип параметра.
+ * @param key Имя параметра.
+ * @param value Значение в текстовом виде.
+ * @return true если параметр известен и значение корректно, иначе false.
+ */
+bool setConfigValue(const string& key, const string& value);
+
+/**
+ * @brief Загружает параметры из файла строк вида "имя = значение" ('#' - комментарий).
+ * @param path Путь к файлу.
+ * @return true если файл прочитан и все параметры корректны, иначе false.
+ */
+bool loadConfigFile(const string& path);
+
+/**
+ * @brief Разбирает аргументы командной строки.
+ *
+ * Поддерживаются "-v" (просмотр обученной сети), "--config <файл>"
+ * и "--<имя> <значение>" / "--<имя>=<значение>" для любого параметра.
+ * Параметр (0/1) без значения означает 1 ("--headless", "--resume").
+ * @param argc Кол-во аргументов.
+ * @param argv Аргументы.
+ * @param type Режим запуска: 't' - обучение, 'v' - просмотр.
+ * @return true если аргументы и их сочетания корректны, иначе false.
+ */
+bool parseArguments(int argc, char* argv[], char& type);
+
+/**
+ * @brief Печатает справку по параметрам.
+ * @param program Имя программы.
+ */
+void printUsage(const char* program);
@@ -0,0 +1,212 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <algorithm>
+#include "gene.h"
+#include "neural_network.h"
+#include "genome_pool.h"
+
+using namespace std;
+
+/**
+ * @brief Ген-нейросеть с топологией, известной на этапе компиляции: In -> Hidden (relu) -> Out (sigmoid).
+ *
+ * Веса лежат в std::array внутри самого гена (та же раскладка [выход][stride], что и у GeneLayer),
+ * все циклы прямого прохода имеют постоянные границы и разворачиваются компилятором.
+ * Инициализация, мутация и скрещивание (crossUniform, addUniformNoise) расходуют случайные числа в том же порядке, что и NeuralGene,
+ * поэтому при одном зерне обе реализации дают одинаковые сети.
+ * Как и у GeneLayer, копии гена разделяют параметры (блок из пула GenomeBlock) до первого изменения.
+ * @tparam In Кол-во входов.
+ * @tparam Hidden Кол-во нейронов скрытого слоя.
+ * @tparam Out Кол-во выходов.
+ */
+template <int In, int Hidden, int Out>
+class FixedNeuralGene : public Gene {
+private:
+    static constexpr int STRIDE_IN = paddedStride(In);
+    static constexpr int STRIDE_HIDDEN = paddedStride(Hidden);
+
+    /**
+     * @brief Веса и смещения гена, общие для всех его копий.
+     */
+    struct Parameters {
+        alignas(32) array<float, Hidden * STRIDE_IN> weights1{};   // Веса скрытого слоя [нейрон][вход]
+        alignas(32) array<float, Out * STRIDE_HIDDEN> weights2{};  // Веса выходного слоя [выход][нейрон]
+        array<float, Hidden> biases1{};                            // Смещения скрытого слоя
+        array<float, Out> biases2{};                               // Смещения выходного слоя
+    };
+
+    GenomeBlock<Parameters> parameters; // Параметры (могут быть общими с копиями гена)
+
+    /**
+     * @brief Отделяет параметры от других копий гена перед изменением.
+     */
+    Parameters& writable() { return parameters.detach(); }
+
+public:
+    FixedNeuralGene() : parameters(GenomeBlock<Parameters>::allocate()) {
+        writable() = Parameters{}; // Блок из пула может хранить веса прежнего гена
+    }
+
+    /**
+     * @brief Создает ген со случайными весами.
+     */
+    explicit FixedNeuralGene(Random& rng) : FixedNeuralGene() {
+        auto& [weights1, weights2, biases1, biases2] = writable();
+        for (int o = 0; o < Hidden; o++) {
+            rng.fillUniform(&weights1[o * STRIDE_IN], In, -1.0f, 1.0f);
+        }
+        for (auto& bias : biases1) {
+            bias = rng.uniform(-1.0f, 1.0f) * 0.3f;
+        }
+        for (int o = 0; o < Out; o++) {
+            rng.fillUniform(&weights2[o * STRIDE_HIDDEN], Hidden, -1.0f, 1.0f);
+        }
+        for (auto& bias : biases2) {
+            bias = rng.uniform(-1.0f, 1.0f) * 0.3f;
+        }
+    }
+
+    /**
+     * @brief Копирует веса из сети той же топологии.
+     */
+    explicit FixedNeuralGene(const NeuralNetwork& network) : FixedNeuralGene() {
+        auto& [weights1, weights2, biases1, biases2] = writable();
+        const GeneLayer& layer1 = *network.getLayers()[0];
+        const GeneLayer& layer2 = *network.getLayers()[1];
+        for (int o = 0; o < Hidden; o++) {
+            for (int i = 0; i < In; i++) {
+                weights1[o * STRIDE_IN + i] = layer1.getWeight(i, o);
+            }
+            biases1[o] = layer1.getBiases()[o];
+        }
+        for (int o = 0; o < Out; o++) {
+            for (int i = 0; i < Hidden; i++) {
+                weights2[o * STRIDE_HIDDEN + i] = layer2.getWeight(i, o);
+            }
+            biases2[o] = layer2.getBiases()[o];
+        }
+    }
+
+    /**
+     * @brief Проверяет, подходит ли сеть под эту топологию (размеры и активации relu/sigmoid).
+     */
+    static bool matches(const NeuralNetwork& network) {
+        const auto& layers = network.getLayers();
+        return layers.size() == 2
+            && layers[0]->getInputSize() == In && layers[0]->getOutputSize() == Hidden && layers[0]->getActivationType() == ACTIVATION_RELU
+            && layers[1]->getInputSize() == Hidden && layers[1]->getOutputSize() == Out && layers[1]->getActivationType() == ACTIVATION_SIGMOID;
+    }
+
+    /**
+     * @brief Прямой проход без выделения памяти и без ветвлений по топологии.
+     */
+    void forward(const float* inputs, float* outputs) const {
+        const auto& [weights1, weights2, biases1, biases2] = *parameters;
+        float hidden[Hidden];
+        for (int o = 0; o < Hidden; o++) {
+            float sum = 0.0f;
+            for (int i = 0; i < In; i++) {
+                sum += inputs[i] * weights1[o * STRIDE_IN + i];
+            }
+            hidden[o] = max(0.0f, sum + biases1[o]);
+        }
+        for (int o = 0; o < Out; o++) {
+            float sum = 0.0f;
+            for (int i = 0; i < Hidden; i++) {
+                sum += hidden[i] * weights2[o * STRIDE_HIDDEN + i];
+            }
+            outputs[o] = 1.0f / (1.0f + exp(-(sum + biases2[o])));
+        }
+    }
+
+    pair<int, int> decideDirection(const Cell* surroundings, int /*energy*/, pair<int, int> directionToFood, int distanceToFood) override {
+        float inputs[In];
+        float outputs[Out];
+        NeuralGene::encodeInputs(surroundings, directionToFood, distanceToFood, inputs);
+        forward(inputs, outputs);
+        return NeuralGene::directionFromOutputs(outputs, Out);
+    }
+
+    void mutate(float mutationPower, Random& rng) override {
+        Parameters& own = writable();
+        for (int o = 0; o < Hidden; o++) {
+            addUniformNoise(&own.weights1[o * STRIDE_IN], In, mutationPower, rng);
+        }
+        addUniformNoise(own.biases1.data(), Hidden, mutationPower * 0.5f, rng);
+        for (int o = 0; o < Out; o++) {
+            addUniformNoise(&own.weights2[o * STRIDE_HIDDEN], Hidden, mutationPower, rng);
+        }
+        addUniformNoise(own.biases2.data(), Out, mutationPower * 0.5f, rng);
+    }
+
+    /**
+     * @brief Копия гена разделяет параметры с оригиналом.
+     */
+    unique_ptr<Gene> clone() const override {
+        return make_unique<FixedNeuralGene>(*this);
+    }
+
+    bool assign(const Gene& otherGene) override {
+        const FixedNeuralGene* other = dynamic_cast<const FixedNeuralGene*>(&otherGene);
+        if (other) {
+            parameters = other->parameters;
+        }
+        return other != nullptr;
+    }
+
+    void crossing(Gene& otherGene, Random& rng) override {
+        FixedNeuralGene* other = dynamic_cast<FixedNeuralGene*>(&otherGene);
+        if (other) {
+            Parameters& own = writable();
+            Parameters& theirs = other->writable();
+            crossUniform(own.weights1.data(), theirs.weights1.data(), Hidden * STRIDE_IN, rng);
+            crossUniform(own.biases1.data(), theirs.biases1.data(), Hidden, rng);
+            crossUniform(own.weights2.data(), theirs.weights2.data(), Out * STRIDE_HIDDEN, rng);
+            crossUniform(own.biases2.data(), theirs.biases2.data(), Out, rng);
+        }
+    }
+
+    string saveDataCSV() const override {
+        stringstream data;
+        data << fixed;
+        const auto& [weights1, weights2, biases1, biases2] = *parameters;
+
+        data << "InputValues;InHiddenLayer;OutputValues;ActivationMid;ActivationLast\n";
+        data << In << ";" << Hidden << ";" << Out << ";relu;sigmoid\n";
+
+        // В файле порядок весов [вход][выход], как у NeuralGene
+        for (int i = 0; i < In; i++) {
+            for (int o = 0; o < Hidden; o++) {
+                data << weights1[o * STRIDE_IN + i] << "\n";
+            }
+        }
+        for (float bias : biases1) {
+            data << bias << "\n";
+        }
+        for (int i = 0; i < Hidden; i++) {
+            for (int o = 0; o < Out; o++) {
+                data << weights2[o * STRIDE_HIDDEN + i] << "\n";
+            }
+        }
+        for (float bias : biases2) {
+            data << bias << "\n";
+        }
+
+        return data.str();
+    }
+
+    int getLayerCount() const override { return 2; }
+
+    LayerView getLayer(int index) const override {
+        const auto& [weights1, weights2, biases1, biases2] = *parameters;
+        if (index == 0) {
+            return {In, Hidden, STRIDE_IN, weights1.data(), biases1.data(), ACTIVATION_RELU};
+        }
+        return {Hidden, Out, STRIDE_HIDDEN, weights2.data(), biases2.data(), ACTIVATION_SIGMOID};
+    }
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vector>
+#include "grid.h"
+
+using namespace std;
+
+/**
+ * @brief Поле расстояний до ближайшей достижимой еды.
+ *
+ * Строится в начале тика многоисточниковым поиском в ширину от всех клеток с едой.
+ * Стены непроходимы, агенты - проходимы (они двигаются).
+ * После построения направление и расстояние к еде для любой клетки - одно чтение из массива.
+ * Съеденная еда делает поле устаревшим (invalidate), и оно строится заново перед следующим
+ * чтением (update), поэтому агент видит ту же еду, что и через индекс еды.
+ */
+class FoodField {
+private:
+    int width;              // Ширина поля
+    int height;             // Высота поля
+    vector<int> distances;  // Расстояние до ближайшей еды (-1 - еда недостижима)
+    vector<int> sources;    // Индекс клетки ближайшей еды
+    vector<int> queue;      // Очередь обхода (выделена заранее)
+    bool stale;             // Еда менялась после построения
+
+public:
+    FoodField();
+
+    /**
+     * @brief Создает поле расстояний для поля указанного размера.
+     * @param width Ширина поля (со стенами).
+     * @param height Высота поля (со стенами).
+     */
+    FoodField(int width, int height);
+
+    /**
+     * @brief Пересчитывает расстояния от всех клеток с едой.
+     * @param grid Поле клеток.
+     */
+    void build(const Grid& grid);
+
+    /**
+     * @brief Отмечает поле устаревшим (еда съедена или появилась после построения).
+     */
+    void invalidate() { stale = true; }
+
+    /**
+     * @brief Строит поле заново, если оно устарело.
+     */
+    void update(const Grid& grid) {
+        if (stale) {
+            build(grid);
+        }
+    }
+
+    /**
+     * @brief Возвращает расстояние до ближайшей достижимой еды.
+     * @return Кол-во шагов или -1, если еда недостижима.
+     */
+    int getDistance(int x, int y) const { return distances[y * width + x]; }
+
+    /**
+     * @brief Возвращает координаты ближайшей достижимой еды.
+     * @return true если еда достижима, иначе false.
+     */
+    bool getNearest(int x, int y, int& foodX, int& foodY) const;
+};
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Пространственный индекс клеток с едой.
+ *
+ * Поле разбито на квадратные корзины BUCKET_SIZE x BUCKET_SIZE, в каждой хранится список клеток с едой.
+ * Поиск ближайшей еды обходит корзины кольцами вокруг агента и останавливается,
+ * как только следующее кольцо не может содержать более близкую клетку.
+ */
+class FoodIndex {
+private:
+    static constexpr int BUCKET_SIZE = 8;
+
+    int width;                   // Ширина поля
+    int height;                  // Высота поля
+    int bucketsX;                // Кол-во корзин по x
+    int bucketsY;                // Кол-во корзин по y
+    vector<vector<int>> buckets; // Индексы клеток с едой в каждой корзине
+    vector<int> slots;           // Позиция клетки внутри своей корзины (-1 - еды нет)
+    int count;                   // Всего клеток с едой
+
+    int bucketOf(int x, int y) const { return (y / BUCKET_SIZE) * bucketsX + x / BUCKET_SIZE; }
+
+public:
+    FoodIndex();
+
+    /**
+     * @brief Создает пустой индекс для поля указанного размера.
+     * @param width Ширина поля (со стенами).
+     * @param height Высота поля (со стенами).
+     */
+    FoodIndex(int width, int height);
+
+    /**
+     * @brief Добавляет клетку с едой.
+     */
+    void add(int x, int y);
+
+    /**
+     * @brief Убирает клетку с едой (если она есть в индексе).
+     */
+    void remove(int x, int y);
+
+    /**
+     * @brief Удаляет всю еду из индекса.
+     */
+    void clear();
+
+    /**
+     * @brief Возвращает кол-во клеток с едой.
+     */
+    int size() const { return count; }
+
+    /**
+     * @brief Ищет ближайшую по манхэттенскому расстоянию еду.
+     *
+     * При равном расстоянии выбирается клетка с меньшим x, затем с меньшим y.
+     * @param x Координата X агента.
+     * @param y Координата Y агента.
+     * @param foodX Координата X найденной еды.
+     * @param foodY Координата Y найденной еды.
+     * @return true если еда есть на поле, иначе false.
+     */
+    bool findNearest(int x, int y, int& foodX, int& foodY) const;
+};
@@ -4,6 +4,8 @@
 #include <memory>
 // #include "agent_logic.h"
 #include "cells.h"
+#include "random.h"
+#include "layer_view.h"
 
 using namespace std;
 
@@ -20,19 +22,32 @@ public:
 
     /**
      * @brief Выбрать направление движения на основе окружения, энергии и направления к еде.
-     * @param surroundings Окружающие клетки (8 клеток).
+     * @param surroundings Окружающие клетки (4 клетки).
      * @param energy Кол-во энергии агента.
      * @param directionToFood Вектор направления к ближайшей еде.
+     * @param distanceToFood Расстояние до ближайшей еды (-1 - еды нет).
      * @return (delta_x, delta_y) - вектор направления.
      */
-    virtual pair<int, int> decideDirection(const vector<Cell>& surroundings, int energy, pair<int, int> directionToFood) = 0;
+    virtual pair<int, int> decideDirection(const Cell* surroundings, int energy, pair<int, int> directionToFood, int distanceToFood) = 0;
+
+    /**
+     * @brief Мутирует ген на месте.
+     * @param mutationPower Сила мутации.
+     * @param rng Генератор случайных чисел.
+     */
+    virtual void mutate(float mutationPower, Random& rng) = 0;
 
     /**
      * @brief Создать мутированную копию гена.
      * @param mutationPower Сила мутации.
+     * @param rng Генератор случайных чисел.
      * @return Указатель на мутированный ген.
      */
-    virtual unique_ptr<Gene> mutation(float mutationPower) const = 0;
+    virtual unique_ptr<Gene> mutation(float mutationPower, Random& rng) const {
+        unique_ptr<Gene> mutated = clone();
+        mutated->mutate(mutationPower, rng);
+        return mutated;
+    }
 
     /**
      * @brief Создать копию гена.
@@ -40,11 +55,19 @@ public:
      */
     virtual unique_ptr<Gene> clone() const = 0;
 
+    /**
+     * @brief Делает ген копией другого гена, переиспользуя собственную память.
+     * @param otherGene Образец.
+     * @return false если гены разных типов или топологий (тогда нужен clone()).
+     */
+    virtual bool assign(const Gene& /*otherGene*/) { return false; }
+
     /**
      * @brief Скрещивает гены с другим геном, изменяя оба
      * @param otherGene Другой ген для скрещивания
+     * @param rng Генератор случайных чисел.
      */
-    virtual void crossing(Gene& otherGene) = 0;
+    virtual void crossing(Gene& otherGene, Random& rng) = 0;
     
     // Методы для сохранения/загрузки гена
 
@@ -52,6 +75,19 @@ public:
      * 
      */
     virtual string saveDataCSV() const = 0;
+
+    // Доступ к весам для пакетного вывода
+
+    /**
+     * @brief Возвращает кол-во полносвязных слоев (0 - ген не нейросеть, пакетный вывод недоступен).
+     */
+    virtual int getLayerCount() const { return 0; }
+
+    /**
+     * @brief Возвращает слой для чтения весов.
+     * @param index Номер слоя от входа.
+     */
+    virtual LayerView getLayer(int /*index*/) const { return LayerView{}; }
     
     // virtual void deserialize() = 0;
 };
\ No newline at end of file
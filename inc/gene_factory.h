@@ -0,0 +1,27 @@
+#pragma once
+
+#include <memory>
+#include "gene.h"
+#include "neural_network.h"
+
+using namespace std;
+
+/**
+ * @brief Создает ген со случайной сетью текущей топологии (InputValues, NeuronsInHiddenLayer, OutputValues).
+ *
+ * Для стандартных топологий возвращается FixedNeuralGene нужной специализации,
+ * для остальных (или при выключенном UseFixedTopology) - универсальный NeuralGene.
+ * @param rng Генератор случайных чисел.
+ */
+unique_ptr<Gene> createRandomGene(Random& rng);
+
+/**
+ * @brief Создает ген по готовой сети (например, загруженной из архива геномов).
+ * @param network Сеть с весами.
+ */
+unique_ptr<Gene> createGene(unique_ptr<NeuralNetwork> network);
+
+/**
+ * @brief Проверяет, есть ли специализация под указанную топологию.
+ */
+bool hasFixedTopology(int inputs, int hidden, int outputs);
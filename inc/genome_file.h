@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "gene.h"
+#include "layer_view.h"
+#include "mapped_file.h"
+#include "neural_network.h"
+
+using namespace std;
+
+/*
+ * Двоичный архив геномов (версия 1). Все числа - little-endian, все блоки выровнены по 32 байта.
+ *
+ *   Заголовок файла (32 байта): "AGNM", версия, выравнивание записей (32), резерв.
+ *   Записи подряд до конца файла, каждая:
+ *     Заголовок записи (32 байта): "GREC", размер записи в байтах, кол-во слоев, поколение,
+ *                                   средняя энергия, резерв, контрольная сумма FNV-1a (64 бита).
+ *     Описания слоев (по 16 байт): входы, выходы, stride, активация; дополнение нулями до 32 байт.
+ *     Параметры слоев по порядку: веса [выход][stride] (хвосты строк нулевые),
+ *                                 смещения [выход], дополненные нулями до 8 чисел.
+ *   Контрольная сумма считается по всем байтам записи после ее заголовка.
+ *
+ * Раскладка весов совпадает с GeneLayer (см. paddedStride), поэтому слои отображенного в память
+ * файла читаются через LayerView прямо из отображения, без разбора и копирования.
+ */
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "Genome archives are read by mapping little-endian data directly"
+#endif
+
+/**
+ * @brief Запись архива: геном и условия, при которых он сохранен.
+ */
+struct GenomeRecord {
+    int generation;            // Поколение
+    int averageEnergy;         // Средняя энергия популяции
+    vector<LayerView> layers;  // Слои (указывают в отображение файла)
+};
+
+/**
+ * @brief Архив геномов, отображенный в память только для чтения.
+ *
+ * При открытии проверяются заголовки всех записей (сами веса не читаются), недописанный
+ * хвост файла (например, после аварийного завершения) отбрасывается.
+ */
+class GenomeArchive {
+private:
+    MappedFile file;            // Отображение файла
+    size_t validSize;           // Размер целых записей с заголовком файла
+    vector<size_t> offsets;     // Смещения записей
+
+public:
+    GenomeArchive();
+
+    /**
+     * @brief Отображает файл в память и строит оглавление записей.
+     * @return false если файл не открылся или это не архив геномов.
+     */
+    bool open(const string& path);
+
+    void close();
+
+    int getRecordCount() const { return offsets.size(); }
+
+    /**
+     * @brief Возвращает размер файла без недописанного хвоста.
+     */
+    size_t getValidSize() const { return validSize; }
+
+    /**
+     * @brief Возвращает запись (указатели действительны, пока архив открыт).
+     */
+    GenomeRecord getRecord(int index) const;
+
+    /**
+     * @brief Сверяет контрольную сумму записи (читает все ее веса).
+     */
+    bool verify(int index) const;
+};
+
+/**
+ * @brief Дописывает геномы в двоичный архив.
+ */
+class GenomeWriter {
+private:
+    ofstream file;
+    vector<unsigned char> buffer;  // Собираемая запись
+
+public:
+    /**
+     * @brief Открывает архив на дописывание (создает новый, недописанный хвост старого отрезается).
+     * @return false если файл существует, но это не архив геномов, или его нельзя открыть.
+     */
+    bool open(const string& path);
+
+    bool isOpen() const { return file.is_open(); }
+
+    /**
+     * @brief Дописывает запись.
+     * @return false если у генома нет полносвязных слоев или запись не удалась.
+     */
+    bool write(const vector<LayerView>& layers, int generation, int averageEnergy);
+
+    /**
+     * @brief Дописывает ген (через Gene::getLayer).
+     */
+    bool write(const Gene& gene, int generation, int averageEnergy);
+};
+
+/**
+ * @brief Дописывает запись генома в буфер (тот же формат используют контрольные точки, см. checkpoint.h).
+ * @return Размер записи, 0 если у генома нет слоев или их слишком много (буфер не меняется).
+ */
+size_t appendGenomeRecord(vector<unsigned char>& out, const vector<LayerView>& layers, int generation, int averageEnergy);
+
+/**
+ * @brief Проверяет запись генома в начале буфера (заголовки и размеры, без контрольной суммы).
+ * @param record Если не nullptr - заполняется слоями записи (указывают в буфер).
+ * @return Размер записи, 0 если запись повреждена или не помещается в буфер.
+ */
+size_t readGenomeRecord(const unsigned char* bytes, size_t available, GenomeRecord* record);
+
+/**
+ * @brief Контрольная сумма FNV-1a (64 бита).
+ */
+uint64_t fnv1a(const unsigned char* bytes, size_t count);
+
+/**
+ * @brief Создает сеть по записи архива.
+ */
+unique_ptr<NeuralNetwork> createNetwork(const GenomeRecord& record);
+
+/**
+ * @brief Переводит CSV-архив (записи NeuralGene::saveDataCSV подряд) в двоичный архив.
+ *
+ * Читает все записи файла, поколение и энергия берутся из строки после весов каждой записи.
+ * @return Кол-во переведенных записей, -1 при ошибке.
+ */
+int convertCsvToGenomes(const string& csvPath, const string& genomePath);
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <atomic>
+
+using namespace std;
+
+/**
+ * @brief Общий блок параметров генома с подсчетом ссылок, выделяемый из пула.
+ *
+ * Копии дескриптора ссылаются на один блок (копирование при записи, см. detach).
+ * Освобожденный блок не удаляется, а возвращается в список свободных блоков своего типа
+ * вместе с содержимым, поэтому буферы внутри T (векторы весов) сохраняют емкость и при повторной
+ * выдаче блока заполняются без обращения к куче. После прогрева (когда пул дорос до пикового
+ * числа одновременно живых геномов) смена поколений не выделяет память.
+ * У каждого потока свой список свободных блоков, поэтому выдача и возврат не берут общих блокировок
+ * (острова и арены не ждут друг друга). Блок возвращается в список потока, отпустившего последнюю ссылку;
+ * при завершении потока его свободные блоки удаляются.
+ * @tparam T Параметры генома (копируемый тип).
+ */
+template <class T>
+class GenomeBlock {
+private:
+    struct Node {
+        T value;
+        atomic<int> references{1};
+        Node* nextFree = nullptr;
+    };
+
+    /**
+     * @brief Список свободных блоков потока. Удаляет блоки при завершении потока.
+     */
+    struct FreeList {
+        Node* head = nullptr;
+
+        ~FreeList() {
+            while (head) {
+                Node* next = head->nextFree;
+                delete head;
+                head = next;
+            }
+            closed = true;
+        }
+    };
+
+    static inline thread_local FreeList freeNodes;  // Свободные блоки потока (память не возвращается в кучу)
+    static inline thread_local bool closed = false; // Список потока уже удален (блоки, живущие дольше потока)
+
+    Node* node = nullptr;
+
+    /**
+     * @brief Берет свободный блок потока (с прежним содержимым) или создает новый.
+     */
+    static Node* acquire() {
+        if (!closed && freeNodes.head) {
+            Node* reused = freeNodes.head;
+            freeNodes.head = reused->nextFree;
+            reused->references.store(1, memory_order_relaxed);
+            return reused;
+        }
+        return new Node();
+    }
+
+    void release() {
+        if (node && node->references.fetch_sub(1, memory_order_acq_rel) == 1) {
+            if (closed) {
+                delete node;
+            } else {
+                node->nextFree = freeNodes.head;
+                freeNodes.head = node;
+            }
+        }
+        node = nullptr;
+    }
+
+public:
+    GenomeBlock() = default;
+
+    GenomeBlock(const GenomeBlock& other) : node(other.node) {
+        if (node) {
+            node->references.fetch_add(1, memory_order_relaxed);
+        }
+    }
+
+    GenomeBlock(GenomeBlock&& other) noexcept : node(other.node) { other.node = nullptr; }
+
+    GenomeBlock& operator=(const GenomeBlock& other) {
+        if (node != other.node) {
+            GenomeBlock copy(other);
+            swap(node, copy.node);
+        }
+        return *this;
+    }
+
+    GenomeBlock& operator=(GenomeBlock&& other) noexcept {
+        if (this != &other) {
+            release();
+            node = other.node;
+            other.node = nullptr;
+        }
+        return *this;
+    }
+
+    ~GenomeBlock() { release(); }
+
+    /**
+     * @brief Выдает блок из пула. Содержимое не определено (остается от прежнего владельца) - его нужно заполнить.
+     */
+    static GenomeBlock allocate() {
+        GenomeBlock block;
+        block.node = acquire();
+        return block;
+    }
+
+    const T& operator*() const { return node->value; }
+    const T* operator->() const { return &node->value; }
+
+    /**
+     * @brief Возвращает параметры для изменения, сначала отделяя их от других владельцев.
+     */
+    T& detach() {
+        if (node->references.load(memory_order_acquire) > 1) {
+            Node* own = acquire();
+            own->value = node->value; // Емкость буферов блока из пула уже подходит
+            release();
+            node = own;
+        }
+        return node->value;
+    }
+
+    bool operator==(const GenomeBlock& other) const { return node == other.node; }
+    bool operator!=(const GenomeBlock& other) const { return node != other.node; }
+};
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include "cells.h"
+
+using namespace std;
+
+/**
+ * @brief Плоское поле клеток, окруженное стенами.
+ *
+ * Клетки хранятся одним непрерывным буфером построчно (индекс = y * ширина + x).
+ * Тип клетки и энергетическая ценность еды лежат в отдельных плоскостях,
+ * поэтому сканирование по типу читает по одному байту на клетку.
+ * Пустые клетки дополнительно собраны в массив с удалением перестановкой,
+ * который обновляется при каждой смене типа и позволяет выбрать случайную пустую клетку за O(1).
+ * Клетки, сменившие тип, попадают в список измененных, который читают отрисовка и статистика.
+ */
+class Grid {
+private:
+    int width;               // Ширина с учетом стен
+    int height;              // Высота с учетом стен
+    vector<uint8_t> types;   // Плоскость типов клеток (CellType)
+    vector<int> foodValues;  // Плоскость энергетической ценности еды
+    vector<int> emptyCells;  // Индексы пустых клеток
+    vector<int> emptySlots;  // Позиция клетки в emptyCells (-1 - клетка не пустая)
+    vector<int> dirtyCells;  // Клетки, сменившие тип после последнего clearDirty()
+    vector<uint8_t> dirtyFlags; // Признак нахождения клетки в dirtyCells
+    int typeCounts[4];       // Кол-во клеток каждого типа
+
+    /**
+     * @brief Отмечает клетку как измененную.
+     */
+    void markDirty(int i) {
+        if (!dirtyFlags[i]) {
+            dirtyFlags[i] = 1;
+            dirtyCells.push_back(i);
+        }
+    }
+
+    /**
+     * @brief Заново собирает массив пустых клеток и счетчики типов.
+     */
+    void rebuildIndex();
+
+public:
+    Grid();
+
+    /**
+     * @brief Создает поле, ограниченное стенами.
+     * @param innerWidth Ширина внутренней части поля.
+     * @param innerHeight Высота внутренней части поля.
+     */
+    Grid(int innerWidth, int innerHeight);
+
+    /**
+     * @brief Возвращает ширину поля вместе со стенами.
+     */
+    int getWidth() const { return width; }
+
+    /**
+     * @brief Возвращает высоту поля вместе со стенами.
+     */
+    int getHeight() const { return height; }
+
+    /**
+     * @brief Возвращает общее количество клеток.
+     */
+    int getSize() const { return width * height; }
+
+    /**
+     * @brief Переводит координаты в индекс буфера.
+     */
+    int index(int x, int y) const { return y * width + x; }
+
+    /**
+     * @brief Проверяет, лежат ли координаты внутри поля.
+     */
+    bool inBounds(int x, int y) const { return x >= 0 && x < width && y >= 0 && y < height; }
+
+    CellType getType(int x, int y) const { return (CellType)types[index(x, y)]; }
+    CellType getType(int i) const { return (CellType)types[i]; }
+
+    void setType(int x, int y, CellType type) { setType(index(x, y), type); }
+
+    void setType(int i, CellType type) {
+        CellType old = (CellType)types[i];
+        if (old == type) {
+            return;
+        }
+
+        if (old == EMPTY) {
+            // Удаление перестановкой с последней пустой клеткой
+            int slot = emptySlots[i];
+            int last = emptyCells.back();
+            emptyCells[slot] = last;
+            emptySlots[last] = slot;
+            emptyCells.pop_back();
+            emptySlots[i] = -1;
+        } else if (type == EMPTY) {
+            emptySlots[i] = emptyCells.size();
+            emptyCells.push_back(i);
+        }
+
+        types[i] = (uint8_t)type;
+        typeCounts[old]--;
+        typeCounts[type]++;
+        markDirty(i);
+    }
+
+    int getFoodValue(int x, int y) const { return foodValues[index(x, y)]; }
+
+    void setFoodValue(int x, int y, int value) { foodValues[index(x, y)] = value; }
+
+    /**
+     * @brief Собирает клетку из плоскостей типа и еды.
+     */
+    Cell getCell(int x, int y) const { return {getType(x, y), getFoodValue(x, y)}; }
+
+    /**
+     * @brief Возвращает кол-во клеток указанного типа.
+     */
+    int getCount(CellType type) const { return typeCounts[type]; }
+
+    /**
+     * @brief Возвращает кол-во пустых клеток.
+     */
+    int getEmptyCount() const { return emptyCells.size(); }
+
+    /**
+     * @brief Возвращает индекс k-й пустой клетки (порядок произвольный).
+     * @param k Номер от 0 до getEmptyCount() - 1.
+     */
+    int getEmptyCell(int k) const { return emptyCells[k]; }
+
+    /**
+     * @brief Возвращает клетки, сменившие тип после последнего clearDirty().
+     */
+    const vector<int>& getDirtyCells() const { return dirtyCells; }
+
+    /**
+     * @brief Сбрасывает список измененных клеток.
+     */
+    void clearDirty();
+
+    /**
+     * @brief Возвращает плоскость типов клеток.
+     */
+    const vector<uint8_t>& getTypes() const { return types; }
+
+    /**
+     * @brief Возвращает плоскость энергетической ценности еды.
+     */
+    const vector<int>& getFoodValues() const { return foodValues; }
+
+    /**
+     * @brief Возвращает индексы пустых клеток в текущем порядке.
+     */
+    const vector<int>& getEmptyCells() const { return emptyCells; }
+
+    /**
+     * @brief Восстанавливает поле того же размера из сохраненных плоскостей (контрольная точка).
+     *
+     * Порядок пустых клеток восстанавливается как был: от него зависит выбор случайной пустой клетки.
+     * Все клетки отмечаются измененными, чтобы отрисовка нарисовала поле заново.
+     * @param types Плоскость типов (getSize() клеток).
+     * @param foodValues Плоскость еды (getSize() клеток).
+     * @param emptyCells Индексы пустых клеток.
+     * @param emptyCount Кол-во пустых клеток.
+     * @return false если данные не согласованы (поле при этом очищается).
+     */
+    bool restore(const uint8_t* types, const int* foodValues, const int* emptyCells, int emptyCount);
+
+    /**
+     * @brief Очищает все клетки, кроме стен.
+     */
+    void clear();
+};
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <functional>
+#include "gene.h"
+#include "grid.h"
+#include "simulation.h"
+
+using namespace std;
+
+/**
+ * @brief Топология обмена мигрантами между островами.
+ */
+enum MigrationTopology {
+    RING,            // Остров i отправляет мигрантов острову i + 1
+    FULLY_CONNECTED  // Каждый остров отправляет мигрантов всем остальным
+};
+
+/**
+ * @brief Параметры островной модели.
+ */
+struct IslandSettings {
+    int islandCount;             // Кол-во островов
+    int migrationInterval;       // Миграция каждые N поколений
+    int migrantCount;            // Кол-во лучших геномов, отправляемых за раз
+    MigrationTopology topology;  // Топология обмена
+};
+
+/**
+ * @brief Островная модель эволюции.
+ *
+ * Каждый остров - отдельная симуляция со своим генетическим алгоритмом и своей силой мутации,
+ * работающая в своем потоке без общих барьеров. Раз в migrationInterval поколений остров
+ * отправляет копии лучших геномов соседям и забирает пришедших к нему мигрантов вместо худших агентов.
+ * Входящие мигранты копятся в lock-free стеке каждого острова.
+ */
+class IslandModel {
+private:
+    /**
+     * @brief Пачка мигрантов от одного острова (узел lock-free стека).
+     */
+    struct MigrantBatch {
+        vector<unique_ptr<Gene>> genes;
+        MigrantBatch* next;
+    };
+
+    /**
+     * @brief Остров: симуляция и входящие мигранты.
+     */
+    struct Island {
+        unique_ptr<EvolutionSimulation> sim;
+        atomic<MigrantBatch*> inbox;
+    };
+
+    IslandSettings settings;
+    vector<unique_ptr<Island>> islands;
+
+    /**
+     * @brief Цикл поколений одного острова.
+     */
+    void runIsland(int index, int generations, const function<void(int, EvolutionSimulation&)>& onGeneration);
+
+    /**
+     * @brief Отправляет копии лучших геномов острова соседям по топологии.
+     */
+    void emigrate(int index);
+
+    /**
+     * @brief Забирает пришедших мигрантов и заменяет ими худших агентов острова.
+     */
+    void immigrate(int index);
+
+    /**
+     * @brief Кладет пачку во входящие острова (без блокировок).
+     */
+    void push(int index, MigrantBatch* batch);
+
+public:
+    /**
+     * @brief Создает острова на копиях поля.
+     * @param field Поле со стенами.
+     * @param settings Параметры модели.
+     */
+    IslandModel(const Grid& field, IslandSettings settings);
+
+    ~IslandModel();
+
+    /**
+     * @brief Запускает все острова параллельно (по потоку на остров) и ждет их завершения.
+     * @param generations Кол-во поколений на каждом острове.
+     * @param onGeneration Вызывается в потоке острова после оценки каждого поколения (популяция отсортирована).
+     */
+    void run(int generations, const function<void(int, EvolutionSimulation&)>& onGeneration);
+
+    /**
+     * @brief Возвращает кол-во островов.
+     */
+    int getIslandCount() const { return islands.size(); }
+
+    /**
+     * @brief Возвращает симуляцию острова.
+     */
+    EvolutionSimulation& getIsland(int index) { return *islands[index]->sim; }
+};
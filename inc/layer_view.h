@@ -0,0 +1,30 @@
+#pragma once
+
+/**
+ * @brief Функция активации слоя.
+ */
+enum Activation {
+    ACTIVATION_NONE,
+    ACTIVATION_RELU,
+    ACTIVATION_SIGMOID
+};
+
+/**
+ * @brief Шаг строки весов: кол-во входов, округленное вверх до 8 (ширина регистра AVX).
+ */
+constexpr int paddedStride(int inputSize) { return (inputSize + 7) & ~7; }
+
+/**
+ * @brief Доступ только для чтения к полносвязному слою гена.
+ *
+ * Веса - построчно по выходам с шагом stride (см. paddedStride), хвосты строк нулевые.
+ * Через него пакетный вывод читает веса любой реализации гена, не зная ее типа.
+ */
+struct LayerView {
+    int inputSize;          // Кол-во входов
+    int outputSize;         // Кол-во выходов
+    int stride;             // Шаг строки весов
+    const float* weights;   // Веса [выход][stride]
+    const float* biases;    // Смещения [выход]
+    Activation activation;  // Функция активации
+};
@@ -1,6 +1,11 @@
 #pragma once
 
 #include <vector>
+#include <string>
+#include <cstdint>
+
+// Значения параметров по умолчанию. Во время работы используются переменные ниже,
+// которые можно переопределить файлом конфигурации или флагами командной строки (см. config.h)
 
 #define FIELD_WIDTH 20 //36 51 Ширина поля
 #define FIELD_HEIGHT 20 //15 20 Высота поля
@@ -21,8 +26,35 @@
 #define ENERGY_FOOD_VALUE 50 // Энергетическая ценность еды //
 
 #define TICK_MS 50 //150 Интервал между тиками (мс)
+#define RENDER_THREAD 1 // Отрисовка в отдельном потоке по снимкам: симуляция не ждет терминал
+#define FRAME_MS 33 // Интервал между кадрами потока отрисовки (мс)
+
+#define RANDOM_SEED 0 // Зерно генератора случайных чисел (0 - случайное при каждом запуске)
+
+#define ARENA_COUNT 0 // Кол-во параллельных арен для оценки поколений без визуализации (0 - одна арена в основном потоке)
+#define WORKER_THREADS 0 // Кол-во рабочих потоков (0 - по числу ядер)
+
+#define ISLAND_COUNT 0 // Кол-во островов островной модели (0 - обычное обучение одной популяции)
+#define MIGRATION_INTERVAL 50 // Миграция лучших геномов между островами каждые N поколений
+#define MIGRANT_COUNT 2 // Кол-во мигрантов, отправляемых островом за раз
+#define MIGRATION_TOPOLOGY 0 // 0 - кольцо, 1 - полносвязная
+
+#define GENOME_FILE "simulation_data.genome" // Двоичный архив лучших геномов (см. genome_file.h)
+
+#define STATS_FILE "simulation_stats.bin" // Двоичный журнал статистики по поколениям (см. stats_sink.h)
+#define STATS_FLUSH_MS 1000 // Интервал записи накопленной статистики на диск (мс)
+
+#define CHECKPOINT_FILE "simulation.checkpoint" // Контрольная точка обучения (см. checkpoint.h)
+#define CHECKPOINT_INTERVAL 0 // Сохранять контрольную точку каждые N поколений и в конце обучения (0 - не сохранять)
+#define CHECKPOINT_IN_BACKGROUND 1 // Записывать контрольные точки в фоновом потоке
+
+#define RECORD_KEYFRAME_INTERVAL 25 // Опорный кадр записи раунда каждые N тиков (см. recording.h)
+#define REPLAY_SPEED 1.0f // Скорость проигрывания записи относительно TICK_MS (0 - без пауз)
 
 #define USE_A_NEURAL_NETWORK 1 // Отвечает за использование нейросети в агентах
+#define USE_FOOD_FIELD 0 // Направление к еде по общему полю расстояний (BFS с учетом стен), считаемому в начале тика и после поедания еды
+#define USE_BATCH_INFERENCE 1 // Пакетный вывод нейросетей всей популяции за тик (сначала все решают, затем все ходят)
+#define USE_FIXED_TOPOLOGY 1 // Специализированные на этапе компиляции сети для стандартных топологий (6-5-4 и др.)
 #define INPUT_VALUES 6 // Входные значения
 // #define HIDDEN_LAYERS 1 // Скрытых слоев
 #define NEURONS_IN_HIDDEN_LAYER 5 //5 Кол-во нейронов в скрытых(ом) слоях(е) // (одинаково)
@@ -32,25 +64,81 @@
 #define AGENT_MUTATION_POWER 0.05f //0.02f Число-диапозон (+, -), которое суммируется с каждым весом
 #define AGENT_CHANCE_TO_CROSS_OVER 0.2f //0.2 0.3 Шанс скрещивания (кроссинговера)
 
+#define SELECTION_SCHEME 0 // Отбор родителей: 0 - равномерный (кроме элиты), 1 - турнир, 2 - ранговый, 3 - усечение
+#define TOURNAMENT_SIZE 3 // Участников турнира
+#define RANK_PRESSURE 1.8f // Давление рангового отбора (1 - нет отбора, 2 - максимальное)
+#define TRUNCATION_SHARE 0.3f // Доля лучших агентов, из которых выбираются родители при усечении
+
 extern bool UseNeuralNetwork;
+extern bool UseFoodField;
+extern bool UseBatchInference;
+extern bool UseFixedTopology;
 extern int InputValues;
 extern int NeuronsInHiddenLayer;
 extern int OutputValues;
 
+extern int FieldWidth;
+extern int FieldHeight;
+extern int Generations;
+extern int SkipGenerations;
+extern int InitPopSize;
+extern int NumberOfSteps;
+extern int InitEnergyAgent;
+extern int EnergyLossPerStep;
+extern int EnergyLossDueToInaction;
+extern int InitFoodCount;
+extern int FoodSpawnInterval;
+extern int FoodAddTimes;
+extern float ChanceOfFoodAppearance;
+extern int EnergyFoodValue;
+extern int TickMs;
+extern bool UseRenderThread;
+extern int FrameMs;
+extern uint64_t RandomSeed;
+extern int ArenaCount;
+extern int WorkerThreads;
+extern int IslandCount;
+extern int MigrationInterval;
+extern int MigrantCount;
+extern int MigrationTopologyMode;
+extern float AgentMutationChance;
+extern float AgentMutationPower;
+extern float AgentChanceToCrossOver;
+extern int SelectionSchemeMode;
+extern int TournamentSize;
+extern float RankPressure;
+extern float TruncationShare;
+extern bool Headless;
+extern std::string GenomeFile;
+extern std::string ConvertCsvFile;
+extern std::string StatsFile;
+extern int StatsFlushMs;
+extern std::string ExportStatsFile;
+extern std::string CheckpointFile;
+extern int CheckpointInterval;
+extern bool CheckpointInBackground;
+extern bool Resume;
+extern std::string RecordDir;
+extern int RecordKeyframeInterval;
+extern std::string ReplayFile;
+extern int ReplayFrom;
+extern int ReplayTo;
+extern float ReplaySpeed;
+
 struct ProgramParameters {
     bool useNeuralNetwork;
     char type; // 't' - обучение, 'v' - обзор
     int InputValues;
     int NeuronsInHiddenLayer;
     int OutputValues;
-    std::vector<std::vector<float>> weights;
-    std::vector<std::vector<float>> biases;
-    std::string activationMid;
-    std::string activationLast;
 };
 
 void settingConstants(ProgramParameters param);
 
 void _train();
 
+void _trainIslands();
+
 void _show();
+
+bool _replay();
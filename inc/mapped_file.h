@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+using namespace std;
+
+/**
+ * @brief Файл, отображенный в память только для чтения.
+ *
+ * Данные не копируются: страницы подгружаются системой при первом обращении,
+ * поэтому открытие большого файла стоит столько же, сколько маленького.
+ */
+class MappedFile {
+private:
+    const unsigned char* data;  // Начало отображения
+    size_t size;                // Размер файла
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#endif
+
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief Отображает файл в память.
+     * @param minSize Минимальный допустимый размер файла (например, размер заголовка).
+     * @return false если файл не открылся, короче minSize или не отобразился.
+     */
+    bool open(const string& path, size_t minSize = 1);
+
+    void close();
+
+    bool isOpen() const { return data != nullptr; }
+
+    const unsigned char* getData() const { return data; }
+
+    size_t getSize() const { return size; }
+};
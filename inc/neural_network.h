@@ -5,62 +5,157 @@
 #include <string>
 #include "gene.h"
 #include "cells.h"
+#include "random.h"
+#include "aligned_allocator.h"
+#include "layer_view.h"
+#include "genome_pool.h"
 
 using namespace std;
 
+/**
+ * @brief Переводит название активации ("relu", "sigmoid") в перечисление.
+ */
+Activation parseActivation(const string& name);
+
+/**
+ * @brief Возвращает название активации (для сохранения в CSV).
+ */
+string activationName(Activation activation);
+
+/**
+ * @brief Полносвязный слой: outputs = activation(W * inputs + biases).
+ *
+ * Веса лежат построчно по выходам с шагом stride, начало каждой строки выровнено по 32 байта.
+ * Ядро (AVX2, SSE или скалярное) выбирается один раз по CPUID при первом вызове.
+ * @param weights Веса [выход][stride].
+ * @param stride Шаг строки весов (paddedStride(inputSize)).
+ * @param biases Смещения [выход].
+ * @param inputs Входы [inputSize].
+ * @param outputs Выходы [outputSize].
+ */
+void denseForward(const float* weights, int stride, const float* biases, const float* inputs, int inputSize, float* outputs, int outputSize, Activation activation);
+
+/**
+ * @brief Равномерное скрещивание двух буферов на месте: каждый элемент меняется местами с вероятностью 1/2.
+ *
+ * Маска обмена берется из битов случайных слов (одно слово на 32 элемента), обмен без ветвлений.
+ * Нулевые хвосты строк можно скрещивать вместе с весами - они остаются нулевыми.
+ */
+void crossUniform(float* first, float* second, int count, Random& rng);
+
+/**
+ * @brief Добавляет к буферу равномерный шум из [-amplitude, amplitude), шум генерируется пачками.
+ */
+void addUniformNoise(float* values, int count, float amplitude, Random& rng);
+
 /**
  * @brief Класс слоя нейронной сети с матрицами весов и смещениями.
+ *
+ * Веса хранятся одним выровненным буфером [выход][вход] с выравниванием строк (см. paddedStride),
+ * хвосты строк всегда нулевые.
+ * Веса и смещения разделяются между копиями слоя (копирование при записи): копия слоя
+ * только увеличивает счетчик ссылок, а буфер копируется при первом изменении (мутация, скрещивание).
+ * Блоки параметров берутся из пула GenomeBlock и после прогрева не выделяются заново.
  */
 class GeneLayer {
 private:
-    vector<vector<float>> weights; // [input] [output]
-    vector<float> biases;          // Смещения для каждого нейрона
-    string activation;             // "sigmoid" или "relu"
+    /**
+     * @brief Параметры слоя, общие для всех его копий.
+     */
+    struct Parameters {
+        AlignedFloats weights;   // [output] [stride]
+        vector<float> biases;    // Смещения для каждого нейрона
+    };
+
+    int inputSize;                      // Кол-во входов
+    int outputSize;                     // Кол-во выходов (нейронов)
+    int stride;                         // Шаг строки весов
+    GenomeBlock<Parameters> parameters; // Веса и смещения (могут быть общими с другими слоями)
+    Activation activation;              // Функция активации
+
+    /**
+     * @brief Отделяет параметры от других копий слоя перед изменением.
+     */
+    Parameters& writable() { return parameters.detach(); }
 
 public:
+    /**
+     * @brief Создает слой с нулевыми весами (для копирования и загрузки).
+     */
     GeneLayer(int inputSize, int outputSize, const string& activation);
+
+    /**
+     * @brief Создает слой со случайными весами.
+     */
+    GeneLayer(int inputSize, int outputSize, const string& activation, Random& rng);
+
+    /**
+     * @brief Создает слой с копией весов (например, из архива геномов).
+     */
+    explicit GeneLayer(const LayerView& layer);
     
     vector<float> forward(const vector<float>& inputs) const;
+
+    /**
+     * @brief Прямой проход без выделения памяти.
+     * @param inputs Входы [getInputSize()].
+     * @param outputs Выходы [getOutputSize()].
+     */
+    void forward(const float* inputs, float* outputs) const {
+        denseForward(parameters->weights.data(), stride, parameters->biases.data(), inputs, inputSize, outputs, outputSize, activation);
+    }
     
     /**
-     * @brief Устанавливает веса слоя.
+     * @brief Устанавливает веса слоя из матрицы [input] [output].
      */
-    void setWeights(const vector<vector<float>>& newWeights) { weights = newWeights; }
+    void setWeights(const vector<vector<float>>& newWeights);
     
     /**
      * @brief Устанавливает bias слоя.
      */
-    void setBiases(const vector<float>& newBiases) { biases = newBiases; }
+    void setBiases(const vector<float>& newBiases) { writable().biases = newBiases; }
     
     /**
-     * @brief Возвращает копию весов слоя.
+     * @brief Возвращает тип активации.
      */
-    vector<vector<float>> getWeightsCopy() const { return weights; }
+    string getActivation() const { return activationName(activation); }
+    Activation getActivationType() const { return activation; }
+
+    int getInputSize() const { return inputSize; }
+    int getOutputSize() const { return outputSize; }
+    int getStride() const { return stride; }
     
     /**
-     * @brief Возвращает копию bias слоя.
+     * @brief Возвращает вес связи вход -> выход.
      */
-    vector<float> getBiasesCopy() const { return biases; }
+    float getWeight(int input, int output) const { return parameters->weights[output * stride + input]; }
     
     /**
-     * @brief Возвращает тип активации.
+     * @brief Возвращает буфер весов [output] [stride] (изменяемая версия отделяет общие параметры).
      */
-    string getActivation() const { return activation; }
+    float* getWeightData() { return writable().weights.data(); }
+    const float* getWeightData() const { return parameters->weights.data(); }
     
     /**
-     * @brief Возвращает веса слоя.
+     * @brief Возвращает bias (изменяемая версия отделяет общие параметры).
      */
-    vector<vector<float>>& getWeights() { return weights; }
-    
+    vector<float>& getBiases() { return writable().biases; }
+    const vector<float>& getBiases() const { return parameters->biases; }
+
     /**
-     * @brief Возвращает bias.
+     * @brief Проверяет, разделяет ли слой параметры с другим слоем.
      */
-    vector<float>& getBiases() { return biases; }
+    bool sharesParameters(const GeneLayer& other) const { return parameters == other.parameters; }
+
+    /**
+     * @brief Возвращает слой для чтения.
+     */
+    LayerView view() const { return {inputSize, outputSize, stride, parameters->weights.data(), parameters->biases.data(), activation}; }
     
     /**
      * @brief Мутирует веса и bias.
      */
-    void mutate(float mutationPower);
+    void mutate(float mutationPower, Random& rng);
 };
 
 /**
@@ -85,6 +180,13 @@ public:
      * @return Выходные значения сети.
      */
     vector<float> predict(const vector<float>& inputs) const;
+
+    /**
+     * @brief Выполняет предсказание без выделения памяти (для сетей шириной до 64 нейронов).
+     * @param inputs Входные значения.
+     * @param outputs Выходные значения (размер - выход последнего слоя).
+     */
+    void predict(const float* inputs, float* outputs) const;
     
     /**
      * @brief Возвращает слои нейронной сети.
@@ -95,10 +197,11 @@ public:
     /**
      * @brief Применяет мутации к весам и bias.
      * @param mutationPower Интенсивность мутаций.
+     * @param rng Генератор случайных чисел.
      */
-    void mutate(float mutationPower);
+    void mutate(float mutationPower, Random& rng);
 
-    void crossing(NeuralNetwork& otherNet);
+    void crossing(NeuralNetwork& otherNet, Random& rng);
     
     /**
      * @brief Создает полную копию нейронной сети.
@@ -106,6 +209,12 @@ public:
      */
     unique_ptr<NeuralNetwork> clone() const;
 
+    /**
+     * @brief Делает сеть копией сети той же топологии без выделения памяти (слои разделяют веса).
+     * @return false если топологии не совпадают.
+     */
+    bool assign(const NeuralNetwork& otherNet);
+
     vector<float> getWeights() const;
 };
 
@@ -117,24 +226,28 @@ private:
     unique_ptr<NeuralNetwork> neuralNet;
 
 public:
-    NeuralGene();
+    /**
+     * @brief Создает ген со случайной сетью текущей топологии.
+     */
+    explicit NeuralGene(Random& rng);
     NeuralGene(unique_ptr<NeuralNetwork> network);
     
     /**
      * @brief Определяет направление движения на основе окружения, энергии и направления к еде.
-     * @param surroundings Вектор клеток окружения (8 клеток)
+     * @param surroundings Клетки окружения (4 клетки)
      * @param energy Уровень энергии агента
      * @param directionToFood Вектор направления к ближайшей еде
+     * @param distanceToFood Расстояние до ближайшей еды (-1 - еды нет)
      * @return (delta_x, delta_y) - вектор направления.
      */
-    pair<int, int> decideDirection(const vector<Cell>& surroundings, int energy, pair<int, int> directionToFood) override;
+    pair<int, int> decideDirection(const Cell* surroundings, int energy, pair<int, int> directionToFood, int distanceToFood) override;
     
     /**
-     * @brief Создает мутированную копию гена.
+     * @brief Мутирует веса сети на месте.
      * @param mutationPower Сила мутации.
-     * @return Умный указатель на мутировавший ген.
+     * @param rng Генератор случайных чисел.
      */
-    unique_ptr<Gene> mutation(float mutationPower) const override;
+    void mutate(float mutationPower, Random& rng) override;
     
     /**
      * @brief Создает точную копию гена.
@@ -142,9 +255,23 @@ public:
      */
     unique_ptr<Gene> clone() const override;
 
-    void crossing(Gene& otherGene) override;
+    bool assign(const Gene& otherGene) override;
+
+    void crossing(Gene& otherGene, Random& rng) override;
 
     NeuralNetwork& getNeuralNet() { return *neuralNet; }
+    const NeuralNetwork& getNeuralNet() const { return *neuralNet; }
+
+    /**
+     * @brief Заполняет входы сети по окружению агента (общий код для одиночного и пакетного вывода).
+     * @param inputs Массив из InputValues чисел.
+     */
+    static void encodeInputs(const Cell* surroundings, pair<int, int> directionToFood, int distanceToFood, float* inputs);
+
+    /**
+     * @brief Переводит выходы сети в направление: наибольший выход, если он больше 0.5, иначе (0, 0).
+     */
+    static pair<int, int> directionFromOutputs(const float* outputs, int count);
 
     /**
      * 
@@ -152,4 +279,7 @@ public:
     void setNewNeuralNet(unique_ptr<NeuralNetwork>& newNeuralNet) { neuralNet = move(newNeuralNet); };
 
     string saveDataCSV() const;
+
+    int getLayerCount() const override { return neuralNet->getLayers().size(); }
+    LayerView getLayer(int index) const override { return neuralNet->getLayers()[index]->view(); }
 };
\ No newline at end of file
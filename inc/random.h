@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+
+using namespace std;
+
+/**
+ * @brief Счетный генератор случайных чисел Philox4x32-10.
+ *
+ * Состояние - 128-битный счетчик и 64-битный ключ. Каждый блок из четырех чисел - это
+ * шифрование текущего значения счетчика ключом, поэтому потоки с разными ключами независимы,
+ * а переход вперед на любое кол-во блоков стоит O(1).
+ * Ключ потока выводится из общего зерна и номера потока (арена, агент, остров).
+ * Удовлетворяет требованиям UniformRandomBitGenerator.
+ */
+class Random {
+private:
+    uint32_t key[2];      // Ключ потока
+    uint32_t counter[4];  // Счетчик блоков
+    uint32_t buffer[4];   // Текущий блок
+    int index;            // Следующее число в блоке (4 - блок исчерпан)
+
+    /**
+     * @brief Шифрует счетчик в новый блок и увеличивает счетчик.
+     */
+    void refill();
+
+public:
+    using result_type = uint32_t;
+
+    Random();
+
+    /**
+     * @brief Создает поток.
+     * @param seed Зерно запуска.
+     * @param stream Номер потока.
+     */
+    Random(uint64_t seed, uint64_t stream);
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return UINT32_MAX; }
+
+    result_type operator()() {
+        if (index == 4) {
+            refill();
+        }
+        return buffer[index++];
+    }
+
+    /**
+     * @brief Возвращает 64 случайных бита.
+     */
+    uint64_t next64() {
+        uint64_t high = (*this)();
+        return (high << 32) | (*this)();
+    }
+
+    /**
+     * @brief Возвращает равномерное число из [lo, hi).
+     */
+    float uniform(float lo, float hi) {
+        return lo + (hi - lo) * ((*this)() >> 8) * (1.0f / 16777216.0f);
+    }
+
+    /**
+     * @brief Возвращает равномерное целое из [lo, hi].
+     */
+    int uniformInt(int lo, int hi);
+
+    /**
+     * @brief Заполняет массив равномерными числами из [lo, hi).
+     */
+    void fillUniform(float* out, int count, float lo, float hi);
+
+    /**
+     * @brief Перемешивает диапазон (Фишер - Йетс).
+     */
+    template <class Iterator>
+    void shuffle(Iterator first, Iterator last) {
+        int count = last - first;
+        for (int i = count - 1; i > 0; i--) {
+            int j = uniformInt(0, i);
+            if (i != j) {
+                swap(first[i], first[j]);
+            }
+        }
+    }
+
+    /**
+     * @brief Порождает новый независимый поток из текущего.
+     */
+    Random split();
+
+    /**
+     * @brief Пропускает указанное кол-во блоков по 4 числа.
+     */
+    void discard(uint64_t blocks);
+};
+
+/**
+ * @brief Смешивает два 64-битных значения в номер потока.
+ */
+uint64_t mixStream(uint64_t a, uint64_t b);
+
+/**
+ * @brief Задает зерно запуска (0 - взять из random_device).
+ * @return Действующее зерно.
+ */
+uint64_t setGlobalSeed(uint64_t seed);
+
+/**
+ * @brief Возвращает зерно запуска.
+ */
+uint64_t getGlobalSeed();
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "grid.h"
+#include "mapped_file.h"
+#include "simulation.h"
+
+using namespace std;
+
+/*
+ * Запись раунда (версия 1). Все числа - little-endian.
+ *
+ *   Заголовок (64 байта): "AGRC", версия, размер файла, контрольная сумма FNV-1a (64 бита) всех
+ *                         байтов после заголовка, размеры поля со стенами, поколение, размер
+ *                         популяции, коэффициент мутации, кол-во кадров, интервал и кол-во опорных
+ *                         кадров, смещение потока событий.
+ *   Оглавление опорных кадров (по 24 байта): номер кадра, резерв, смещение опорного кадра,
+ *                                           смещение события следующего кадра в потоке.
+ *   Опорные кадры: статистика (6 x int32) и типы клеток по 2 бита (4 клетки в байте).
+ *   Поток событий, по записи на кадр начиная с первого:
+ *     кол-во событий, события по возрастанию клетки - (промежуток до прошлой клетки - 1) << 4
+ *     | прежний тип << 2 | новый тип, затем приращения статистики к прошлому кадру (zigzag).
+ *     Все числа потока - varint (по 7 бит в байте, старший бит - продолжение).
+ *
+ * Кадр 0 - поле в начале раунда, кадр N - после N-го тика. Событие - смена типа клетки за тик:
+ * EMPTY -> AGENT и AGENT -> EMPTY - ход агента (или смерть, если прибытия нет - см. счетчик
+ * смертей в статистике), FOOD -> AGENT - съеденная еда, EMPTY -> FOOD - появление еды.
+ * Событие хранит оба типа, поэтому кадры проигрываются в обе стороны без опорных кадров,
+ * а опорные кадры (каждые keyframeInterval кадров) нужны для перехода к произвольному кадру.
+ * Статистика - поля SimulationData, меняющиеся за раунд: еда, средняя, максимальная
+ * и минимальная энергия, живые и мертвые агенты.
+ */
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "Recordings are read by mapping little-endian data directly"
+#endif
+
+static const int RECORDED_STATS = 6; // Кол-во полей статистики в кадре
+
+/**
+ * @brief Опорный кадр в оглавлении записи.
+ */
+struct RecordingKeyframe {
+    uint32_t frame;          // Номер кадра
+    uint32_t reserved;
+    uint64_t offset;         // Смещение опорного кадра в файле
+    uint64_t streamOffset;   // Смещение события кадра frame + 1 в файле
+};
+
+static_assert(sizeof(RecordingKeyframe) == 24, "recording keyframe entry must be 24 bytes");
+
+/**
+ * @brief Записывает раунд потоком событий поля с опорными кадрами.
+ *
+ * Изменения берутся из списка измененных клеток поля и сравниваются с последним записанным кадром,
+ * поэтому запись не зависит от того, когда сбрасывается список (отрисовкой или никогда).
+ * Сети и генераторы не записываются: для просмотра достаточно типов клеток и статистики.
+ * Буферы переиспользуются между раундами.
+ */
+class RoundRecorder {
+private:
+    int width;                          // Ширина поля со стенами
+    int height;                         // Высота поля со стенами
+    int generation;                     // Поколение раунда
+    int populationSize;                 // Размер популяции
+    float mutationPower;                // Коэффициент мутации
+    int keyframeInterval;               // Опорный кадр каждые N кадров
+    int frameCount;                     // Записано кадров
+    vector<uint8_t> shown;              // Типы клеток последнего записанного кадра
+    int32_t shownStats[RECORDED_STATS]; // Статистика последнего записанного кадра
+    vector<int> changed;                // Клетки, сменившие тип за тик
+    vector<RecordingKeyframe> index;    // Оглавление (смещения от начала своих разделов)
+    vector<unsigned char> keyframes;    // Опорные кадры
+    vector<unsigned char> stream;       // Поток событий
+    vector<unsigned char> output;       // Собираемый файл
+
+    /**
+     * @brief Дописывает опорный кадр с текущим состоянием shown и shownStats.
+     */
+    void addKeyframe();
+
+public:
+    RoundRecorder();
+
+    /**
+     * @brief Начинает запись раунда: кадр 0 - текущее поле.
+     * @param keyframeInterval Опорный кадр каждые N кадров.
+     */
+    void begin(const EvolutionSimulation& sim, int keyframeInterval);
+
+    /**
+     * @brief Записывает кадр после тика.
+     */
+    void recordTick(const EvolutionSimulation& sim);
+
+    int getFrameCount() const { return frameCount; }
+
+    /**
+     * @brief Записывает раунд в файл.
+     * @return false если файл не записан.
+     */
+    bool save(const string& path);
+};
+
+/**
+ * @brief Проигрыватель записи раунда: поле и статистика любого кадра без симуляции и нейросетей.
+ *
+ * Файл отображается в память. Соседние кадры получаются применением событий вперед или назад,
+ * дальние - от ближайшего опорного кадра. Клетки, сменившие тип, отмечаются в поле как измененные,
+ * поэтому поле можно рисовать той же отрисовкой, что и симуляцию.
+ */
+class RecordingPlayer {
+private:
+    MappedFile file;
+    Grid grid;                              // Поле текущего кадра
+    int32_t stats[RECORDED_STATS];          // Статистика текущего кадра
+    int generation;                         // Поколение раунда
+    int populationSize;                     // Размер популяции
+    float mutationPower;                    // Коэффициент мутации
+    int frameCount;                         // Кол-во кадров
+    int keyframeInterval;                   // Опорный кадр каждые N кадров
+    int frame;                              // Текущий кадр (-1 до первого seek)
+    vector<RecordingKeyframe> keyframes;    // Оглавление
+    vector<size_t> eventOffsets;            // Смещение события каждого кадра (с первого)
+
+    /**
+     * @brief Переходит к опорному кадру.
+     */
+    void loadKeyframe(const RecordingKeyframe& keyframe);
+
+    /**
+     * @brief Применяет событие кадра target вперед (из target - 1 в target) или назад (из target в target - 1).
+     */
+    bool applyEvents(int target, bool forward);
+
+public:
+    RecordingPlayer();
+
+    /**
+     * @brief Открывает запись и проверяет ее целиком (контрольная сумма, оглавление, поток событий).
+     * @return false если файл не открылся или поврежден.
+     */
+    bool open(const string& path);
+
+    /**
+     * @brief Переходит к кадру.
+     * @return false если кадра нет или запись повреждена.
+     */
+    bool seek(int frame);
+
+    int getFrame() const { return frame; }
+
+    int getFrameCount() const { return frameCount; }
+
+    int getGeneration() const { return generation; }
+
+    /**
+     * @brief Возвращает поле текущего кадра.
+     */
+    const Grid& getGrid() const { return grid; }
+
+    /**
+     * @brief Сбрасывает отметки измененных клеток поля (после отрисовки).
+     */
+    void clearGridChanges() { grid.clearDirty(); }
+
+    /**
+     * @brief Возвращает статистику текущего кадра в виде статистики симуляции.
+     */
+    EvolutionSimulation::SimulationData getSimulationData() const;
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <vector>
+#include "random.h"
+
+using namespace std;
+
+/**
+ * @brief Схема отбора родителей.
+ */
+enum SelectionScheme {
+    SELECTION_UNIFORM,     // Любой агент диапазона с равной вероятностью
+    SELECTION_TOURNAMENT,  // Лучший из нескольких случайных агентов
+    SELECTION_RANK,        // Линейный ранговый отбор (через бинарный турнир с вероятностью)
+    SELECTION_TRUNCATION   // Любой агент из доли лучших
+};
+
+/**
+ * @brief Параметры отбора.
+ */
+struct SelectionSettings {
+    SelectionScheme scheme;  // Схема отбора
+    int tournamentSize;      // Участников турнира
+    float rankPressure;      // Давление рангового отбора: 1 - равномерно, 2 - максимальное
+    float truncationShare;   // Доля лучших для отбора усечением
+};
+
+/**
+ * @brief Отбор родителей по приспособленности, посчитанной один раз за раунд.
+ *
+ * Полная сортировка не нужна ни одной схеме: турнир и ранговый отбор сравнивают
+ * несколько случайных агентов, усечение один раз отделяет долю лучших через nth_element.
+ * Подготовка занимает O(n), каждый выбор - O(1) (турнир - O(tournamentSize)).
+ */
+class ParentSelection {
+private:
+    SelectionSettings settings;
+    const float* fitness;     // Приспособленность агентов (по номерам популяции)
+    int first, last;          // Диапазон номеров, из которого выбираются родители
+    vector<int> candidates;   // Доля лучших для отбора усечением
+
+    /**
+     * @brief Возвращает лучшего из двух агентов.
+     */
+    int better(int a, int b) const { return fitness[b] > fitness[a] ? b : a; }
+
+public:
+    ParentSelection();
+
+    /**
+     * @brief Готовит отбор из диапазона [first, last].
+     * @param fitness Приспособленность агентов, должна жить до конца отбора.
+     */
+    void prepare(const SelectionSettings& settings, const vector<float>& fitness, int first, int last);
+
+    /**
+     * @brief Выбирает родителя.
+     * @return Номер агента в популяции.
+     */
+    int select(Random& rng) const;
+};
+
+/**
+ * @brief Параметры отбора из конфигурации.
+ */
+SelectionSettings getSelectionSettings();
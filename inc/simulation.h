@@ -4,9 +4,16 @@
 #include <memory>
 #include <string>
 #include "cells.h"
+#include "grid.h"
+#include "food_index.h"
+#include "food_field.h"
 #include "agent_logic.h"
+#include "batched_inference.h"
 #include "neural_network.h"
 #include "main.h"
+#include "thread_pool.h"
+#include "random.h"
+#include "selection.h"
 
 using namespace std;
 
@@ -17,14 +24,36 @@ using namespace std;
  */
 class EvolutionSimulation {
 private:
-    vector<vector<Cell>> grid;            // Двумерное поле клеток
+    Grid grid;                            // Поле клеток
+    FoodIndex foodIndex;                  // Индекс клеток с едой
+    FoodField foodField;                  // Поле расстояний до еды (режим UseFoodField)
+    vector<int> vacatedCells;             // Клетки, покинутые агентами за текущий тик
     vector<int> FoodValue;
-    vector<unique_ptr<Agent>> population; // Популяция агентов
+    AgentStore population;                // Популяция агентов (параллельные массивы)
+    AgentStore nextPopulation;            // Буфер следующего поколения (меняется ролями с population)
+    vector<float> fitness;                // Приспособленность агентов за раунд (по номерам популяции)
+    vector<float> rankedFitness;          // Рабочие массивы упорядочивания популяции
+    vector<int> ranking;
+    bool fitnessReady;                    // fitness посчитана по текущему раунду
+    ParentSelection selection;            // Отбор родителей
+    vector<int> order;                    // Порядок хода агентов на текущем тике
+    BatchedInference inference;           // Пакетный вывод нейросетей (режим UseBatchInference)
+    vector<pair<int, int>> decisions;     // Решения агентов, принятые пакетом на текущем тике
+    vector<unique_ptr<EvolutionSimulation>> arenas;  // Арены параллельной оценки (переиспользуются между поколениями)
+    vector<vector<pair<int, int>>> arenaMembers;     // Агенты каждой арены: (номер в популяции, номер в арене)
+    vector<int> arenaTicks;                          // Отработано тиков каждой ареной в последней оценке
     float mutationPower;                  // Коэффициент мутации
     int generation;                       // Текущее поколение
     int totalDeaths;                      // Общее количество смертей
     int totalAlives;                      // Общее количество живых
     int currentTick;                      // Счетчик тиков для контроля появления еды
+    long long energyTotal;                // Суммарная энергия живых агентов
+    int energyMin;                        // Минимальная энергия живых агентов
+    int energyMax;                        // Максимальная энергия живых агентов
+    int energyAgents;                     // Кол-во агентов, учтенных в энергии
+    uint64_t stream;                      // Номер потока случайных чисел симуляции
+    mutable Random rng;                   // Генератор случайных чисел симуляции
+    vector<float> spawnChances;           // Пачка случайных чисел для появления еды
 
     /**
      * @brief Создает начальную популяцию агентов.
@@ -34,16 +63,55 @@ private:
 
     /**
      * @brief Обновляет состояние всех агентов.
+     *
+     * С пакетным выводом тик идет в три фазы: все живые агенты осматриваются по состоянию на начало тика,
+     * сети всей популяции считаются одним пакетом, затем агенты ходят в перемешанном порядке.
+     * Без него каждый агент осматривается и решает непосредственно перед своим ходом.
      * @return Удачно или нет.
      */
     bool updateAgents();
 
+    /**
+     * @brief Убирает агента, если у него кончилась энергия.
+     * @param i Номер агента.
+     * @return true если агент умер.
+     */
+    bool checkStarvation(int i);
+
+    /**
+     * @brief Агент осматривается: окружение и направление к еде.
+     * @param i Номер агента.
+     */
+    void senseAgent(int i);
+
     /**
      * @brief Генерирует новую еду на поле.
+     * @param chance Случайное число из [0, 1) для проверки шанса появления.
+     */
+    void spawnNewFood(float chance);
+
+    /**
+     * @brief Пересчитывает статистику энергии по всей популяции (вне тиков).
+     */
+    void recountEnergy();
+
+    /**
+     * @brief Готовит арену к новому раунду: пустая популяция, новая еда, новый поток случайных чисел.
+     *
+     * Память поля, индексов и буферов сохраняется с прошлого раунда.
+     * @param arenaStream Номер потока случайных чисел арены.
+     */
+    void resetArena(uint64_t arenaStream);
+
+    /**
+     * @brief Отмечает только что добавленного агента на поле и в учете энергии.
      */
-    void spawnNewFood(uniform_int_distribution<int> foodV);
+    void placeAgent(int x, int y, int energy);
 
-    unique_ptr<NeuralNetwork> createNetw(const ProgramParameters& param);
+    /**
+     * @brief Считает приспособленность агентов, если она еще не посчитана в этом раунде.
+     */
+    void updateFitness();
 
 public:
     /**
@@ -51,17 +119,18 @@ public:
      * @param grid Готовое поле клеток с учетом стен.
      * @param initialPopulationSize Начальный размер популяции.
      * @param initialFoodCount Начальное количество еды.
+     * @param stream Номер потока случайных чисел (разный у арен и островов).
      */
-    EvolutionSimulation(vector<vector<Cell>> grid, int initialPopulationSize = INIT_POP_SIZE, int initialFoodCount = INIT_FOOD_COUNT);
+    EvolutionSimulation(Grid grid, int initialPopulationSize = InitPopSize, int initialFoodCount = InitFoodCount, uint64_t stream = 0);
     
     ~EvolutionSimulation();
 
     /**
      * @brief Создает симуляцию с предобученными агентами.
      * @param field Поле.
-     * @param param Параметры с весами нейросети.
+     * @param network Обученная нейросеть (например, из архива геномов).
      */
-    void tuneSimWithTrainedAgents(vector<vector<Cell>> field, const ProgramParameters& param);
+    void tuneSimWithTrainedAgents(const Grid& field, const NeuralNetwork& network);
 
     /**
      * @brief Находит случайную свободную позицию на поле.
@@ -78,10 +147,27 @@ public:
     bool simulateStep();
     
     /**
-     * @brief Обновляет состояние поля.
+     * @brief Обновляет состояние поля: освобождает клетки, покинутые агентами за тик.
      */
     void updateGrid();
 
+    /**
+     * @brief Сбрасывает список измененных клеток поля (после отрисовки).
+     */
+    void clearGridChanges() { grid.clearDirty(); }
+
+    /**
+     * @brief Оценивает популяцию за один раунд в нескольких независимых аренах параллельно.
+     *
+     * Популяция делится между копиями поля, у каждой арены своя еда.
+     * Каждая арена отрабатывает NumberOfSteps тиков в отдельной задаче пула.
+     * После общего барьера энергия, шаги и состояние агентов переносятся обратно в популяцию.
+     * @param pool Пул потоков.
+     * @param arenaCount Кол-во арен.
+     * @return Кол-во тиков, отработанных всеми аренами.
+     */
+    int evaluateInArenas(ThreadPool& pool, int arenaCount);
+
     /**
      * @brief Выполняет процесс эволюции агентов.
      */
@@ -99,9 +185,15 @@ public:
      * @param y Координата Y.
      * @param energy Начальная энергия агента.
      * @param genome Уникальный указатель на геном.
-     * @return Указатель на созданного агента.
+     * @return Номер созданного агента в популяции, -1 если клетка недоступна.
+     */
+    int addAgent(int x, int y, int energy = InitEnergyAgent, unique_ptr<Gene> genome = nullptr);
+
+    /**
+     * @brief Добавляет агента с копией гена (без выделения памяти, если есть отложенный ген той же топологии).
+     * @return Номер созданного агента в популяции, -1 если клетка недоступна.
      */
-    Agent* addAgent(int x, int y, int energy = INIT_ENERGY_AGENT, unique_ptr<Gene> genome = nullptr);
+    int addAgent(int x, int y, int energy, const Gene& genome);
     
     /**
      * @brief Добавляет еду в указанную позицию.
@@ -110,15 +202,15 @@ public:
      * @param energyValue Количество еды.
      * @return true если ресурс добавлен успешно, иначе false.
      */
-    bool addFood(int x, int y, int energyValue = ENERGY_FOOD_VALUE);
+    bool addFood(int x, int y, int energyValue = EnergyFoodValue);
     
     /**
      * @brief Возвращает клетку в указанной позиции.
      * @param x Координата X.
      * @param y Координата Y.
-     * @return Ссылка на клетку.
+     * @return Клетка (стена для невалидных координат).
      */
-    const Cell& getCell(int x, int y) const;
+    Cell getCell(int x, int y) const;
 
     /**
      * @brief Возвращает номер текущего поколения.
@@ -128,15 +220,15 @@ public:
     
     /**
      * @brief Возвращает все клетки поля.
-     * @return Константная ссылка на двумерный вектор клеток.
+     * @return Константная ссылка на поле.
      */
-    const vector<vector<Cell>>& getGrid() const { return grid; }
+    const Grid& getGrid() const { return grid; }
     
     /**
      * @brief Возвращает всех агентов в симуляции.
-     * @return Константная ссылка на вектор агентов.
+     * @return Константная ссылка на хранилище агентов.
      */
-    const vector<unique_ptr<Agent>>& getPopulation() const { return population; }
+    const AgentStore& getPopulation() const { return population; }
 
     /**
      * @brief Структура для хранения данных о симуляции.
@@ -155,23 +247,46 @@ public:
 
     /**
      * @brief Возвращает статистику по текущему состоянию симуляции.
+     *
+     * Счетчики поддерживаются по ходу симуляции (появление/поедание еды, ходы, смерти), поэтому вызов стоит O(1).
      * @return Структура со статистическими данными.
      */
     SimulationData getSimulationData() const;
     
     /**
-     * @brief Сохраняет текущее состояние симуляции в файл.
+     * @brief Собирает снимок всего состояния симуляции (формат - см. checkpoint.h).
+     *
+     * Снимок можно брать на границе любого тика, обычно - после смены поколения.
+     * @param out Буфер снимка (перезаписывается, память переиспользуется).
+     * @param loopPosition Положение в цикле обучения вызывающего кода, возвращается при восстановлении.
+     * @return false если ген какого-то агента нельзя сохранить.
+     */
+    bool saveSnapshot(vector<unsigned char>& out, int loopPosition = 0) const;
+
+    /**
+     * @brief Восстанавливает состояние из снимка.
+     *
+     * Размер поля должен совпадать с текущим. Зерно запуска тоже восстанавливается (от него зависят потоки арен).
+     * @param loopPosition Если не nullptr - сюда записывается положение в цикле обучения.
+     * @return false если снимок поврежден или не подходит (после неудачи симуляцию нужно пересоздать).
+     */
+    bool restoreSnapshot(const unsigned char* data, size_t size, int* loopPosition = nullptr);
+
+    /**
+     * @brief Сохраняет текущее состояние симуляции в файл (атомарно, см. writeFileAtomically).
      * @param filename Имя файла для сохранения.
+     * @param loopPosition Положение в цикле обучения.
      * @return true если сохранение успешно, иначе false.
      */
-    bool saveSimulationState(const string& filename) const;
+    bool saveSimulationState(const string& filename, int loopPosition = 0) const;
     
     /**
-     * @brief Загружает состояние симуляции из файла.
+     * @brief Загружает состояние симуляции из файла, отображая его в память.
      * @param filename Имя файла для загрузки.
+     * @param loopPosition Если не nullptr - сюда записывается положение в цикле обучения.
      * @return true если загрузка успешна, иначе false.
      */
-    bool loadSimulationState(const string& filename);
+    bool loadSimulationState(const string& filename, int* loopPosition = nullptr);
     
     /**
      * @brief Устанавливает коэффициент мутации для новых агентов.
@@ -195,7 +310,29 @@ public:
      */
     void resetSim();
 
-    void sortPop();
+    /**
+     * @brief Упорядочивает популяцию по приспособленности частично, без полной сортировки.
+     *
+     * После вызова лучшая половина стоит перед худшей, первые bestCount агентов (не меньше двух элитных)
+     * отсортированы по убыванию, а худшие worstCount агентов собраны в конце. Стоит O(n + k log k).
+     * @param bestCount Сколько лучших агентов нужно по порядку (элита, мигранты).
+     * @param worstCount Сколько худших агентов нужно собрать в конце (замена мигрантами).
+     */
+    void sortPop(int bestCount = 2, int worstCount = 0);
+
+    /**
+     * @brief Возвращает копии генов лучших агентов (популяция должна быть отсортирована).
+     * @param count Кол-во генов.
+     */
+    vector<unique_ptr<Gene>> cloneBestGenes(int count) const;
+
+    /**
+     * @brief Заменяет гены худших агентов пришедшими (популяция должна быть отсортирована).
+     *
+     * Два лучших агента не заменяются.
+     * @param genes Новые гены.
+     */
+    void replaceWorstGenes(vector<unique_ptr<Gene>>& genes);
 
     /**
      * 
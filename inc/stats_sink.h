@@ -0,0 +1,115 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/*
+ * Двоичный журнал статистики (версия 1). Все числа - little-endian.
+ *
+ *   Заголовок файла (16 байт): "AGST", версия, резерв.
+ *   Блоки подряд до конца файла, каждый:
+ *     Заголовок блока (32 байта): "SBLK", кол-во строк, поколение первой строки, флаги
+ *                                 (1 - строки островов), резерв, контрольная сумма FNV-1a (64 бита).
+ *     Столбцы по очереди: остров (uint16), приращение поколения к предыдущей строке (int16),
+ *                         средняя энергия, шаги лучшего агента, живых агентов (int32).
+ *   Строка занимает 16 байт при любых значениях; поколение между строками растет на 1-2,
+ *   поэтому хранится приращением. Контрольная сумма считается по столбцам блока.
+ *
+ * Блок записывается одной операцией, недописанный блок в конце файла (после аварийного
+ * завершения) отбрасывается при следующем открытии.
+ */
+
+/**
+ * @brief Строка статистики за поколение.
+ */
+struct StatsRow {
+    int island;          // Номер острова (0 без островной модели)
+    int generation;      // Поколение
+    int averageEnergy;   // Средняя энергия популяции
+    int topSteps;        // Шаги первого агента популяции
+    int aliveAgents;     // Живых агентов
+};
+
+/**
+ * @brief Приемник статистики: строки копятся в памяти и пишутся блоками в фоновом потоке.
+ *
+ * add() только копирует строку под блокировкой, поэтому обучение не ждет диска.
+ * Фоновый поток раз в flushInterval миллисекунд забирает накопленные строки
+ * и дописывает их в файл одним блоком (одна запись вместо записи и flush() на каждое поколение).
+ * Можно вызывать из нескольких потоков (острова).
+ */
+class StatsSink {
+private:
+    ofstream file;
+    bool islands;                    // Строки островов (флаг блоков)
+    int flushInterval;               // Интервал записи (мс)
+    vector<StatsRow> rows;           // Накопленные строки
+    vector<StatsRow> writing;        // Строки, записываемые фоновым потоком
+    vector<unsigned char> buffer;    // Собираемый блок
+    bool busy;                       // Фоновый поток пишет writing
+    bool flushRequested;             // Ждут записи всех строк (flush)
+    bool stopping;
+    mutex lock;
+    condition_variable changed;
+    thread worker;
+
+    void run();
+
+    /**
+     * @brief Дописывает строки в файл блоками (приращение поколения должно помещаться в int16).
+     */
+    void writeRows(const vector<StatsRow>& rows);
+
+public:
+    StatsSink();
+
+    /**
+     * @brief Дописывает оставшиеся строки и закрывает файл.
+     */
+    ~StatsSink();
+
+    StatsSink(const StatsSink&) = delete;
+    StatsSink& operator=(const StatsSink&) = delete;
+
+    /**
+     * @brief Открывает журнал на дописывание (создает новый, недописанный хвост старого отрезается).
+     * @param islands Строки пишутся островами.
+     * @param flushInterval Интервал записи в миллисекундах (0 - сразу по мере поступления).
+     * @param resumeGeneration Продолжение обучения с контрольной точки этого поколения: строки с этого
+     *                         поколения в конце журнала (записанные после точки) отрезаются (0 и меньше - не отрезать).
+     * @return false если файл существует, но это не журнал статистики, или его нельзя открыть.
+     */
+    bool open(const string& path, bool islands, int flushInterval, int resumeGeneration = -1);
+
+    bool isOpen() const { return file.is_open(); }
+
+    /**
+     * @brief Добавляет строку (без обращения к диску).
+     */
+    void add(const StatsRow& row);
+
+    /**
+     * @brief Дожидается записи всех добавленных строк.
+     */
+    void flush();
+
+    /**
+     * @brief Дописывает оставшиеся строки, останавливает фоновый поток и закрывает файл.
+     */
+    void close();
+};
+
+/**
+ * @brief Переводит журнал статистики в CSV (столбцы прежнего simulation_stats.csv через ';').
+ *
+ * Столбец Island выводится, если в журнале есть строки островов.
+ * @return Кол-во строк, -1 при ошибке.
+ */
+int exportStatsToCsv(const string& statsPath, const string& csvPath);
@@ -1,30 +1,125 @@
 #pragma once
 
 #include <vector>
+#include <cstdint>
+#include <ostream>
 #include "cells.h"
+#include "grid.h"
 #include "simulation.h"
 #include "main.h"
 
 using namespace std;
 
+/**
+ * @brief Кадр терминала с двойной буферизацией.
+ *
+ * Кадр - прямоугольник символов (поле и таблица под ним). Изменения рисуются в текущий буфер,
+ * измененные строки сравниваются с кадром на экране, и отличающиеся участки строки выводятся
+ * с одним перемещением каретки на участок (короткие совпадающие промежутки внутри участка
+ * переписываются - это дешевле новой escape-последовательности).
+ * Весь кадр собирается в заранее выделенный буфер и уходит в терминал одной записью,
+ * после чего буферы меняются ролями без копирования кадра.
+ */
+class FrameRenderer {
+private:
+    int width;                  // Ширина кадра в символах
+    int height;                 // Высота кадра в строках
+    vector<char> current;       // Рисуемый кадр
+    vector<char> previous;      // Кадр на экране
+    vector<uint8_t> marked;     // Строки, измененные в рисуемом кадре
+    vector<uint8_t> lastMarked; // Строки, измененные в кадре на экране
+    vector<char> output;        // Байты кадра для терминала
+
+    /**
+     * @brief Дописывает в вывод перемещение каретки (строка и столбец с нуля).
+     */
+    void moveCursor(int row, int column);
+
+public:
+    FrameRenderer();
+
+    /**
+     * @brief Задает размер кадра и считает экран пустым.
+     */
+    void resize(int width, int height);
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+
+    /**
+     * @brief Готовит новый кадр: текущий буфер догоняет кадр на экране.
+     *
+     * После обмена буферами в текущем лежит позапрошлый кадр, поэтому копируются
+     * только строки, измененные в прошлом кадре.
+     */
+    void beginFrame();
+
+    /**
+     * @brief Задает символ кадра и отмечает его строку.
+     */
+    void set(int x, int y, char symbol) {
+        current[y * width + x] = symbol;
+        marked[y] = 1;
+    }
+
+    /**
+     * @brief Возвращает строку кадра для записи и отмечает ее.
+     */
+    char* row(int y) {
+        marked[y] = 1;
+        return &current[y * width];
+    }
+
+    /**
+     * @brief Выводит отличия от кадра на экране одной записью и меняет буферы ролями.
+     * @param cursorRow Строка, где оставить каретку после кадра (с нуля).
+     */
+    void present(int cursorRow);
+};
+
 /**
  * @brief Создает поле, ограниченное стенами.
  * @param width Ширина.
  * @param height Высота.
- * @return Двумерное поле.
+ * @return Поле со стенами по краям.
  */
-vector<vector<Cell>> createField(int width, int height);
+Grid createField(int width, int height);
 
 /**
  * @brief Обновляет поле и таблицу статистики.
- * @param field Двумерное поле.
+ * @param field Поле.
  * @param sim Ссылка на симуляцию.
  * @param generation Всего поколений.
  * @param skipGen Пропусков поколений.
  * @param currentStep Текущий шаг.
  * @param totalSteps Всего шагов.
  */
-void updateField(const vector<vector<Cell>>& field, const EvolutionSimulation& sim, int generation, int skipGen, int currentStep, int totalSteps);
+void updateField(const Grid& field, const EvolutionSimulation& sim, int generation, int skipGen, int currentStep, int totalSteps);
+
+/**
+ * @brief Обновляет поле и таблицу статистики по готовой статистике (например, из записи раунда).
+ */
+void updateField(const Grid& field, const EvolutionSimulation::SimulationData& data, int generation, int skipGen, int currentStep, int totalSteps);
+
+/**
+ * @brief Печатает поле текстом, без управляющих последовательностей терминала.
+ */
+void printField(ostream& out, const Grid& field);
+
+/**
+ * @brief Запускает поток отрисовки.
+ *
+ * Дальше updateField не рисует, а копирует плоскость типов клеток и статистику в снимок и публикует
+ * его через тройной буфер (см. triple_buffer.h). Поток раз в frameMs рисует последний снимок, снимки,
+ * опубликованные между кадрами, пропускаются - симуляция отрисовку не ждет.
+ * @param frameMs Интервал между кадрами (мс).
+ */
+void startRenderThread(int frameMs);
+
+/**
+ * @brief Рисует последний опубликованный снимок и останавливает поток отрисовки.
+ */
+void stopRenderThread();
 
 /**
  * @brief Обновляет таблицу статистики.
@@ -34,4 +129,4 @@ void updateField(const vector<vector<Cell>>& field, const EvolutionSimulation& s
  * @param currentStep Текущий шаг.
  * @param totalSteps Всего шагов.
  */
-void updateTable(const EvolutionSimulation& sim, int generation, int skipGen, int currentStep, int totalSteps);
\ No newline at end of file
+void updateTable(const EvolutionSimulation& sim, int generation, int skipGen, int currentStep, int totalSteps);
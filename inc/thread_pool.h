@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+using namespace std;
+
+/**
+ * @brief Пул рабочих потоков с общей очередью задач.
+ *
+ * Очередь - вектор, который очищается, когда все задачи разобраны, поэтому повторные партии задач
+ * (по партии на поколение) не выделяют память, если задача помещается в function без выделения.
+ */
+class ThreadPool {
+private:
+    vector<thread> workers;          // Рабочие потоки
+    vector<function<void()>> tasks;  // Очередь задач (емкость сохраняется, когда очередь пустеет)
+    size_t nextTask;                 // Первая не взятая задача в tasks
+    mutex lock;                      // Защищает очередь и счетчик
+    condition_variable taskReady;    // Появилась задача или пул останавливается
+    condition_variable allDone;      // Все задачи выполнены
+    int pending;                     // Задачи в очереди и в работе
+    bool stopping;                   // Пул останавливается
+
+    void workerLoop();
+
+public:
+    /**
+     * @brief Запускает пул.
+     * @param threadCount Кол-во потоков (0 - по числу ядер машины).
+     */
+    explicit ThreadPool(int threadCount = 0);
+
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Ставит задачу в очередь.
+     */
+    void submit(function<void()> task);
+
+    /**
+     * @brief Ждет завершения всех поставленных задач.
+     */
+    void wait();
+
+    /**
+     * @brief Возвращает кол-во потоков пула.
+     */
+    int size() const { return workers.size(); }
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+using namespace std;
+
+/**
+ * @brief Тройной буфер без блокировок для одного писателя и одного читателя.
+ *
+ * Писатель заполняет свой буфер и публикует его обменом с промежуточным, читатель забирает
+ * промежуточный буфер обменом со своим. Обе стороны никогда не ждут друг друга: если читатель
+ * не успевает, непрочитанный снимок просто заменяется более новым (кадр пропускается).
+ * Буферы переиспользуются, поэтому после первого заполнения публикация не выделяет память.
+ * @tparam T Снимок (публикуется целиком, после публикации писатель его не трогает).
+ */
+template <class T>
+class TripleBuffer {
+private:
+    static constexpr uint8_t INDEX_MASK = 3;
+    static constexpr uint8_t FRESH = 4;   // В промежуточном буфере новый, еще не прочитанный снимок
+
+    T slots[3];
+    atomic<uint8_t> middle;  // Номер промежуточного буфера и признак FRESH
+    uint8_t back;            // Буфер писателя
+    uint8_t front;           // Буфер читателя
+
+    static_assert(atomic<uint8_t>::is_always_lock_free, "triple buffer index must be lock-free");
+
+public:
+    TripleBuffer() : middle(1), back(0), front(2) {}
+
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    /**
+     * @brief Возвращает буфер писателя для заполнения.
+     */
+    T& writeBuffer() { return slots[back]; }
+
+    /**
+     * @brief Публикует заполненный буфер писателя (непрочитанный прежний снимок отбрасывается).
+     */
+    void publish() {
+        uint8_t previous = middle.exchange(back | FRESH, memory_order_acq_rel);
+        back = previous & INDEX_MASK;
+    }
+
+    /**
+     * @brief Забирает последний опубликованный снимок, если он новее уже прочитанного.
+     * @return true если readBuffer() сменился.
+     */
+    bool consume() {
+        if (!(middle.load(memory_order_relaxed) & FRESH)) {
+            return false;
+        }
+        uint8_t previous = middle.exchange(front, memory_order_acq_rel);
+        front = previous & INDEX_MASK;
+        return true;
+    }
+
+    /**
+     * @brief Возвращает снимок читателя (действителен до следующего consume()).
+     */
+    const T& readBuffer() const { return slots[front]; }
+};
@@ -7,112 +7,105 @@
 
 using namespace std;
 
-// Вспомогательная функция для генерации случайных чисел
-static mt19937 rng(random_device{}());
-
-Agent::Agent() : x(0), y(0), energy(INIT_ENERGY_AGENT), steps(0), isAlive(true), directionToFood({0,0}) {}
-
-Agent::Agent(int x, int y, int energy, unique_ptr<Gene> gene)
-    : x(x), y(y), energy(energy), steps(0), isAlive(true), directionToFood({0,0})
-{
-    if (gene) {
-        this->gene = std::move(gene);
-    } else {
-        initializeBrain();
-    }
-}
-
-Agent::~Agent() {}
-
 void Agent::dEnergy(int amount) {
+    int& energy = store->energy[index];
     energy += amount;
     if (energy < 0) energy = 0;
 }
 
-void Agent::stepTick() {
-    steps++;
-}
+void Agent::lookAround(const Grid& grid) {
+    int x = getX();
+    int y = getY();
+    Cell* surroundings = &store->surroundings[index * 4];
 
-void Agent::lookAround(vector<vector<Cell>>* grid) {
-    surroundings.clear();
-    
     // 4 клетки вокруг агента
-    vector<pair<int, int>> directions = {
+    static const pair<int, int> directions[4] = {
                 {0, -1},
         {-1, 0},        {1, 0},
                 {0, 1}
     };
-    
-    for (const auto& [dx, dy] : directions) {
-        int newX = x + dx;
-        int newY = y + dy;
 
-        surroundings.push_back((*grid)[newX][newY]);
+    for (int i = 0; i < 4; i++) {
+        surroundings[i] = grid.getCell(x + directions[i].first, y + directions[i].second);
     }
 }
 
-const pair<int, int>& Agent::getDirectionToFood(vector<vector<Cell>>* grid) {
-    int minDistance = INT_MAX;
-    directionToFood = {0, 0};
+pair<int, int> Agent::getDirectionToFood(const FoodIndex& food) {
+    int x = getX();
+    int y = getY();
+    int foodX, foodY;
+    store->directionToFood[index] = {0, 0};
+    store->distanceToFood[index] = -1;
     
-    for (int i = 0; i < grid->size(); ++i) {
-        for (int j = 0; j < (*grid)[i].size(); ++j) {
-            if ((*grid)[i][j].type == FOOD) {
-                int distance = abs(i - x) + abs(j - y);
-
-                if (distance < minDistance) {
-                    minDistance = distance;
-                    // directionToFood = {i - x, j - y};
-                    if (i >= x && y >= j) {
-                        directionToFood = {1, 1};
-                    } else if (i >= x && y < j) {
-                        directionToFood = {1, -1};
-                    } else if (i < x && y >= j) {
-                        directionToFood = {-1, 1};
-                    } else if (i < x && y < j) {
-                        directionToFood = {-1, -1};
-                    }
-                }
-            }
-        }
+    if (food.findNearest(x, y, foodX, foodY)) {
+        store->distanceToFood[index] = abs(foodX - x) + abs(foodY - y);
+        setDirectionTo(foodX, foodY);
     }
     
-    return directionToFood;
+    return store->directionToFood[index];
 }
 
-bool Agent::randomMovement(const vector<vector<Cell>>& grid) {
-    vector<pair<int, int>> directions = {{0, 1}, {0, -1}, {-1, 0}, {1, 0}}; // Вверх, вниз, влево, вправо
-    vector<pair<int, int>> availableDirections;
+pair<int, int> Agent::getDirectionToFood(const FoodField& field) {
+    int x = getX();
+    int y = getY();
+    int foodX, foodY;
+    store->directionToFood[index] = {0, 0};
+    store->distanceToFood[index] = -1;
+    
+    if (field.getNearest(x, y, foodX, foodY)) {
+        store->distanceToFood[index] = field.getDistance(x, y);
+        setDirectionTo(foodX, foodY);
+    }
+    
+    return store->directionToFood[index];
+}
+
+void Agent::setDirectionTo(int foodX, int foodY) {
+    int x = getX();
+    int y = getY();
+    pair<int, int>& directionToFood = store->directionToFood[index];
+    // directionToFood = {foodX - x, foodY - y};
+    if (foodX >= x && y >= foodY) {
+        directionToFood = {1, 1};
+    } else if (foodX >= x && y < foodY) {
+        directionToFood = {1, -1};
+    } else if (foodX < x && y >= foodY) {
+        directionToFood = {-1, 1};
+    } else if (foodX < x && y < foodY) {
+        directionToFood = {-1, -1};
+    }
+}
+
+bool Agent::randomMovement(const Grid& grid) {
+    static const pair<int, int> directions[4] = {{0, 1}, {0, -1}, {-1, 0}, {1, 0}}; // Вверх, вниз, влево, вправо
+    pair<int, int> availableDirections[4];
+    int availableCount = 0;
+    int x = getX();
+    int y = getY();
 
     for (const auto& [dx, dy] : directions) {
         int newX = x + dx;
         int newY = y + dy;
 
-        if (grid[newX][newY].type == EMPTY || grid[newX][newY].type == FOOD) {
-            availableDirections.push_back({dx, dy});
+        if (grid.getType(newX, newY) == EMPTY || grid.getType(newX, newY) == FOOD) {
+            availableDirections[availableCount++] = {dx, dy};
         }
     }
     
-    if (availableDirections.empty()) {
+    if (availableCount == 0) {
         return move(0, 0, grid);
     }
     
-    uniform_int_distribution<int> dist(0, availableDirections.size() - 1);
-    auto [dx, dy] = availableDirections[dist(rng)];
+    auto [dx, dy] = availableDirections[store->rng[index].uniformInt(0, availableCount - 1)];
     return move(dx, dy, grid);
 }
 
-bool Agent::decideAction(const vector<vector<Cell>>& grid) {
+bool Agent::decideAction(const Grid& grid) {
     if (UseNeuralNetwork == 1) {
         // Использование гена для принятия решения
         while (true) {
-            auto direction = gene->decideDirection(surroundings, energy, directionToFood);
-            
-            if (direction.first == 0 && direction.second == 0) {
-                return randomMovement(grid);
-            } else {
-                return move(direction.first, direction.second, grid);
-            }
+            auto direction = getGene().decideDirection(getSurroundings(), getEnergy(), store->directionToFood[index], getDistanceToFood());
+            return act(direction, grid);
         }
     } else if (UseNeuralNetwork == 0) {
         // Случайное движение
@@ -121,52 +114,51 @@ bool Agent::decideAction(const vector<vector<Cell>>& grid) {
     return 0;
 }
 
-bool Agent::move(int dx, int dy, const vector<vector<Cell>>& grid) {
+bool Agent::act(pair<int, int> direction, const Grid& grid) {
+    if (direction.first == 0 && direction.second == 0) {
+        return randomMovement(grid);
+    }
+    return move(direction.first, direction.second, grid);
+}
+
+bool Agent::move(int dx, int dy, const Grid& grid) {
     if (dx == 0 && dy == 0) {
-        dEnergy(-ENERGY_LOSS_DUE_TO_INACTION);
+        dEnergy(-EnergyLossDueToInaction);
         return false;
     }
 
-    int newX = x + dx;
-    int newY = y + dy;
+    int newX = getX() + dx;
+    int newY = getY() + dy;
 
-    if (grid[newX][newY].type == WALL || grid[newX][newY].type == AGENT) {
-        dEnergy(-ENERGY_LOSS_DUE_TO_INACTION);
+    if (grid.getType(newX, newY) == WALL || grid.getType(newX, newY) == AGENT) {
+        dEnergy(-EnergyLossDueToInaction);
         return false;
     }
     
-    x = newX;
-    y = newY;
+    setX(newX);
+    setY(newY);
     
-    dEnergy(-ENERGY_LOSS_PER_STEP);
+    dEnergy(-EnergyLossPerStep);
 
-    if (grid[newX][newY].type == FOOD) {
-        dEnergy(grid[newX][newY].foodValue);
+    if (grid.getType(newX, newY) == FOOD) {
+        dEnergy(grid.getFoodValue(newX, newY));
     }
     
     return true;
 }
 
-unique_ptr<Agent> Agent::clone() {
-    unique_ptr<Gene> clonedGene = gene->clone();
-
-    auto newAgent = make_unique<Agent>(x, y, energy, std::move(clonedGene));
-    
-    return newAgent;
+Agent Agent::clone(AgentStore& target, Random rng) const {
+    int copy = target.addCopy(getX(), getY(), getEnergy(), getGene(), rng);
+    return Agent(&target, copy);
 }
 
 void Agent::mutateGene(float mutationPower) {
-    gene = gene->mutation(mutationPower);
+    getGene().mutate(mutationPower, store->rng[index]); // Ген потомка уже свой, мутируем на месте
+    store->markGenesChanged();
 }
 
-void Agent::crossing(Agent& pair) {
-    gene->crossing(pair.getGene());
+void Agent::crossing(Agent pair) {
+    getGene().crossing(pair.getGene(), store->rng[index]);
+    store->markGenesChanged();
+    pair.store->markGenesChanged(); // Скрещивание меняет оба гена
 }
-
-void Agent::die() {
-    isAlive = false;
-}
-
-void Agent::initializeBrain() {
-    gene = make_unique<NeuralGene>();
-}
\ No newline at end of file
@@ -0,0 +1,124 @@
+#include <atomic>
+#include <algorithm>
+#include "agent_store.h"
+#include "gene_factory.h"
+
+using namespace std;
+
+static atomic<uint64_t> nextGenesVersion{1};
+
+void AgentStore::markGenesChanged() {
+    genesVersion = nextGenesVersion.fetch_add(1, memory_order_relaxed);
+}
+
+void AgentStore::reserve(int count) {
+    x.reserve(count);
+    y.reserve(count);
+    energy.reserve(count);
+    steps.reserve(count);
+    alive.reserve(count);
+    geneIndex.reserve(count);
+    rng.reserve(count);
+    surroundings.reserve(count * 4);
+    directionToFood.reserve(count);
+    distanceToFood.reserve(count);
+    genes.reserve(count);
+    spareGenes.reserve(count);
+    permuted.reserve(count);
+}
+
+void AgentStore::clear() {
+    x.clear();
+    y.clear();
+    energy.clear();
+    steps.clear();
+    alive.clear();
+    geneIndex.clear();
+    rng.clear();
+    surroundings.clear();
+    directionToFood.clear();
+    distanceToFood.clear();
+    for (auto& gene : genes) {
+        spareGenes.push_back(move(gene));
+    }
+    genes.clear();
+    markGenesChanged();
+}
+
+int AgentStore::add(int newX, int newY, int newEnergy, unique_ptr<Gene> gene, Random newRng) {
+    int index = size();
+
+    x.push_back(newX);
+    y.push_back(newY);
+    energy.push_back(newEnergy);
+    steps.push_back(0);
+    alive.push_back(1);
+    rng.push_back(newRng);
+    surroundings.resize(surroundings.size() + 4, Cell{EMPTY, 0});
+    directionToFood.push_back({0, 0});
+    distanceToFood.push_back(-1);
+
+    if (!gene) {
+        gene = createRandomGene(rng.back()); // Случайный мозг из собственного потока агента
+    }
+    geneIndex.push_back(genes.size());
+    genes.push_back(move(gene));
+    markGenesChanged();
+
+    return index;
+}
+
+int AgentStore::addCopy(int newX, int newY, int newEnergy, const Gene& source, Random newRng) {
+    unique_ptr<Gene> gene;
+    if (!spareGenes.empty()) {
+        gene = move(spareGenes.back());
+        spareGenes.pop_back();
+    }
+    if (!gene || !gene->assign(source)) {
+        gene = source.clone();
+    }
+    return add(newX, newY, newEnergy, move(gene), newRng);
+}
+
+/**
+ * @brief Переставляет массив на месте, обходя циклы перестановки (без временной копии массива).
+ * @param stride Кол-во элементов на агента (не больше 4).
+ */
+template <class T>
+static void permuteArray(vector<T>& values, const vector<int>& order, vector<uint8_t>& permuted, int stride = 1) {
+    permuted.assign(order.size(), 0);
+    T held[4];
+
+    for (int start = 0; start < (int)order.size(); start++) {
+        if (permuted[start]) {
+            continue;
+        }
+
+        // На место i встает элемент order[i], цикл замыкается на start
+        copy_n(&values[start * stride], stride, held);
+        int i = start;
+        while (true) {
+            permuted[i] = 1;
+            int from = order[i];
+            if (from == start) {
+                copy_n(held, stride, &values[i * stride]);
+                break;
+            }
+            copy_n(&values[from * stride], stride, &values[i * stride]);
+            i = from;
+        }
+    }
+}
+
+void AgentStore::permute(const vector<int>& order) {
+    permuteArray(x, order, permuted);
+    permuteArray(y, order, permuted);
+    permuteArray(energy, order, permuted);
+    permuteArray(steps, order, permuted);
+    permuteArray(alive, order, permuted);
+    permuteArray(geneIndex, order, permuted); // Гены остаются на месте, меняются только ссылки на них
+    permuteArray(rng, order, permuted);
+    permuteArray(surroundings, order, permuted, 4);
+    permuteArray(directionToFood, order, permuted);
+    permuteArray(distanceToFood, order, permuted);
+}
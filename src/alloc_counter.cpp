@@ -0,0 +1,75 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include "alloc_counter.h"
+
+using namespace std;
+
+#ifdef COUNT_ALLOCATIONS
+
+static atomic<uint64_t> allocationCount{0};
+
+static void* countedAlloc(size_t size) {
+    allocationCount.fetch_add(1, memory_order_relaxed);
+    if (void* pointer = malloc(size ? size : 1)) {
+        return pointer;
+    }
+    throw bad_alloc();
+}
+
+static void* countedAlignedAlloc(size_t size, align_val_t alignment) {
+    allocationCount.fetch_add(1, memory_order_relaxed);
+    size_t align = static_cast<size_t>(alignment);
+    size = (size + align - 1) / align * align; // aligned_alloc требует размер, кратный выравниванию
+#ifdef _WIN32
+    void* pointer = _aligned_malloc(size ? size : align, align);
+#else
+    void* pointer = aligned_alloc(align, size ? size : align);
+#endif
+    if (pointer) {
+        return pointer;
+    }
+    throw bad_alloc();
+}
+
+static void alignedFree(void* pointer) {
+#ifdef _WIN32
+    _aligned_free(pointer);
+#else
+    free(pointer);
+#endif
+}
+
+void* operator new(size_t size) { return countedAlloc(size); }
+void* operator new[](size_t size) { return countedAlloc(size); }
+void* operator new(size_t size, align_val_t alignment) { return countedAlignedAlloc(size, alignment); }
+void* operator new[](size_t size, align_val_t alignment) { return countedAlignedAlloc(size, alignment); }
+
+void operator delete(void* pointer) noexcept { free(pointer); }
+void operator delete[](void* pointer) noexcept { free(pointer); }
+void operator delete(void* pointer, size_t) noexcept { free(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { free(pointer); }
+void operator delete(void* pointer, align_val_t) noexcept { alignedFree(pointer); }
+void operator delete[](void* pointer, align_val_t) noexcept { alignedFree(pointer); }
+void operator delete(void* pointer, size_t, align_val_t) noexcept { alignedFree(pointer); }
+void operator delete[](void* pointer, size_t, align_val_t) noexcept { alignedFree(pointer); }
+
+bool allocationCountingEnabled() {
+    return true;
+}
+
+uint64_t getAllocationCount() {
+    return allocationCount.load(memory_order_relaxed);
+}
+
+#else
+
+bool allocationCountingEnabled() {
+    return false;
+}
+
+uint64_t getAllocationCount() {
+    return 0;
+}
+
+#endif
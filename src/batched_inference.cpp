@@ -0,0 +1,117 @@
+#include <algorithm>
+#include "batched_inference.h"
+#include "main.h"
+
+using namespace std;
+
+BatchedInference::BatchedInference() : built(false), compatible(false), builtVersion(0) {}
+
+bool BatchedInference::prepare(const AgentStore& store) {
+    if (!built || builtVersion != store.genesVersion) {
+        compatible = build(store);
+        builtVersion = store.genesVersion;
+        built = true;
+    }
+    return compatible;
+}
+
+bool BatchedInference::build(const AgentStore& store) {
+    sizes.clear();
+    strides.clear();
+    activations.clear();
+
+    int geneCount = store.genes.size();
+    if (geneCount == 0) {
+        return false;
+    }
+
+    // Топология берется из первого гена, остальные должны совпадать с ней
+    const Gene& first = *store.genes[0];
+    int layerCount = first.getLayerCount();
+    if (layerCount == 0) {
+        return false;
+    }
+
+    sizes.push_back(first.getLayer(0).inputSize);
+    for (int l = 0; l < layerCount; l++) {
+        LayerView layer = first.getLayer(l);
+        sizes.push_back(layer.outputSize);
+        strides.push_back(layer.stride);
+        activations.push_back(layer.activation);
+    }
+
+    if (sizes[0] != InputValues || sizes.back() != OutputValues) {
+        return false;
+    }
+
+    weights.resize(layerCount);
+    biases.resize(layerCount);
+    for (int l = 0; l < layerCount; l++) {
+        weights[l].resize((size_t)geneCount * sizes[l + 1] * strides[l]);
+        biases[l].resize((size_t)geneCount * sizes[l + 1]);
+    }
+
+    for (int g = 0; g < geneCount; g++) {
+        const Gene& gene = *store.genes[g];
+        if (gene.getLayerCount() != layerCount) {
+            return false;
+        }
+
+        for (int l = 0; l < layerCount; l++) {
+            LayerView layer = gene.getLayer(l);
+            int out = sizes[l + 1];
+
+            if (layer.inputSize != sizes[l] || layer.outputSize != out || layer.stride != strides[l] || layer.activation != activations[l]) {
+                return false;
+            }
+
+            // Раскладка одна у всех реализаций гена, поэтому блок копируется целиком
+            copy(layer.weights, layer.weights + (size_t)out * strides[l], weights[l].begin() + (size_t)g * out * strides[l]);
+            copy(layer.biases, layer.biases + out, biases[l].begin() + (size_t)g * out);
+        }
+    }
+
+    return true;
+}
+
+void BatchedInference::decide(const AgentStore& store, vector<pair<int, int>>& decisions) {
+    decisions.assign(store.size(), {0, 0});
+
+    rows.clear();
+    for (int i = 0; i < store.size(); i++) {
+        if (store.alive[i]) {
+            rows.push_back(i);
+        }
+    }
+
+    int batch = rows.size();
+    int maxSize = *max_element(sizes.begin(), sizes.end());
+    current.resize((size_t)batch * maxSize);
+    next.resize((size_t)batch * maxSize);
+
+    // Собираем входы всех агентов в одну матрицу
+    for (int r = 0; r < batch; r++) {
+        int agent = rows[r];
+        NeuralGene::encodeInputs(&store.surroundings[agent * 4], store.directionToFood[agent], store.distanceToFood[agent], &current[(size_t)r * sizes[0]]);
+    }
+
+    // Прогоняем пакет слой за слоем
+    for (int l = 0; l < (int)activations.size(); l++) {
+        int in = sizes[l], out = sizes[l + 1];
+        Activation activation = activations[l];
+
+        for (int r = 0; r < batch; r++) {
+            int gene = store.geneIndex[rows[r]];
+            denseForward(&weights[l][(size_t)gene * out * strides[l]], strides[l], &biases[l][(size_t)gene * out],
+                         &current[(size_t)r * in], in, &next[(size_t)r * out], out, activation);
+        }
+
+        current.swap(next);
+    }
+
+    // Раскладываем решения обратно по агентам
+    int outputs = sizes.back();
+    for (int r = 0; r < batch; r++) {
+        decisions[rows[r]] = NeuralGene::directionFromOutputs(&current[(size_t)r * outputs], outputs);
+    }
+}
@@ -0,0 +1,391 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <type_traits>
+#include "checkpoint.h"
+#include "gene_factory.h"
+#include "genome_file.h"
+#include "mapped_file.h"
+#include "simulation.h"
+
+#ifdef _WIN32
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <cerrno>
+    #include <cstdio>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+using namespace std;
+
+static const char SNAPSHOT_MAGIC[4] = {'A', 'G', 'C', 'P'};
+static const uint32_t SNAPSHOT_VERSION = 1;
+static const size_t ALIGNMENT = 32;
+
+// Генератор сохраняется побайтно: ключ, счетчик, текущий блок и позиция в нем
+static_assert(is_trivially_copyable<Random>::value && sizeof(Random) == 11 * sizeof(uint32_t), "Random state must be 11 plain words");
+
+struct SnapshotHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t size;           // Размер файла вместе с заголовком
+    uint64_t checksum;       // FNV-1a по байтам после заголовка
+    uint64_t seed;           // Зерно запуска
+    uint64_t stream;         // Номер потока симуляции
+    int32_t width;           // Размеры поля со стенами
+    int32_t height;
+    int32_t agentCount;
+    int32_t foodValueCount;
+    int32_t emptyCount;
+    int32_t generation;
+    float mutationPower;
+    int32_t totalDeaths;
+    int32_t totalAlives;
+    int32_t currentTick;
+    int32_t loopPosition;
+    uint32_t rng[11];        // Генератор симуляции
+};
+
+static_assert(sizeof(SnapshotHeader) == 128, "checkpoint header must be 128 bytes");
+
+static size_t alignUp(size_t bytes) { return (bytes + ALIGNMENT - 1) & ~(ALIGNMENT - 1); }
+
+/**
+ * @brief Дописывает раздел снимка, дополняя его нулями до выравнивания.
+ */
+static void appendSection(vector<unsigned char>& out, const void* bytes, size_t count) {
+    size_t start = out.size();
+    out.resize(start + alignUp(count), 0);
+    if (count > 0) {
+        memcpy(out.data() + start, bytes, count);
+    }
+}
+
+/**
+ * @brief Последовательное чтение разделов снимка с проверкой границ.
+ */
+struct SectionReader {
+    const unsigned char* data;
+    size_t size;
+    size_t offset;
+
+    /**
+     * @brief Возвращает начало следующего раздела из count байт, nullptr если он не помещается в снимок.
+     */
+    const unsigned char* take(size_t count) {
+        if (alignUp(count) > size - offset) {
+            return nullptr;
+        }
+        const unsigned char* section = data + offset;
+        offset += alignUp(count);
+        return section;
+    }
+};
+
+bool EvolutionSimulation::saveSnapshot(vector<unsigned char>& out, int loopPosition) const {
+    int agentCount = population.size();
+    int cellCount = grid.getSize();
+
+    out.clear();
+    out.resize(sizeof(SnapshotHeader), 0);
+
+    appendSection(out, grid.getTypes().data(), cellCount);
+    appendSection(out, grid.getFoodValues().data(), cellCount * sizeof(int));
+    appendSection(out, grid.getEmptyCells().data(), grid.getEmptyCount() * sizeof(int));
+    appendSection(out, FoodValue.data(), FoodValue.size() * sizeof(int));
+
+    appendSection(out, population.x.data(), agentCount * sizeof(int));
+    appendSection(out, population.y.data(), agentCount * sizeof(int));
+    appendSection(out, population.energy.data(), agentCount * sizeof(int));
+    appendSection(out, population.steps.data(), agentCount * sizeof(int));
+    appendSection(out, population.alive.data(), agentCount);
+    appendSection(out, population.rng.data(), agentCount * sizeof(Random));
+
+    vector<LayerView> layers;
+    for (int i = 0; i < agentCount; i++) {
+        const Gene& gene = population.gene(i);
+        layers.clear();
+        for (int l = 0; l < gene.getLayerCount(); l++) {
+            layers.push_back(gene.getLayer(l));
+        }
+        if (appendGenomeRecord(out, layers, generation, population.energy[i]) == 0) {
+            return false;
+        }
+    }
+
+    SnapshotHeader header{};
+    memcpy(header.magic, SNAPSHOT_MAGIC, 4);
+    header.version = SNAPSHOT_VERSION;
+    header.size = out.size();
+    header.seed = getGlobalSeed();
+    header.stream = stream;
+    header.width = grid.getWidth();
+    header.height = grid.getHeight();
+    header.agentCount = agentCount;
+    header.foodValueCount = FoodValue.size();
+    header.emptyCount = grid.getEmptyCount();
+    header.generation = generation;
+    header.mutationPower = mutationPower;
+    header.totalDeaths = totalDeaths;
+    header.totalAlives = totalAlives;
+    header.currentTick = currentTick;
+    header.loopPosition = loopPosition;
+    memcpy(header.rng, &rng, sizeof(header.rng));
+    header.checksum = fnv1a(out.data() + sizeof(header), out.size() - sizeof(header));
+    memcpy(out.data(), &header, sizeof(header));
+
+    return true;
+}
+
+bool EvolutionSimulation::restoreSnapshot(const unsigned char* data, size_t size, int* loopPosition) {
+    SnapshotHeader header;
+    if (size < sizeof(header)) {
+        return false;
+    }
+    memcpy(&header, data, sizeof(header));
+
+    if (memcmp(header.magic, SNAPSHOT_MAGIC, 4) != 0 || header.version != SNAPSHOT_VERSION || header.size != size) {
+        cerr << "Not a checkpoint or truncated checkpoint\n";
+        return false;
+    }
+    if (fnv1a(data + sizeof(header), size - sizeof(header)) != header.checksum) {
+        cerr << "Checkpoint checksum mismatch\n";
+        return false;
+    }
+    if (header.width != grid.getWidth() || header.height != grid.getHeight()) {
+        cerr << "Checkpoint field is " << header.width - 2 << "x" << header.height - 2
+             << ", configured field is " << grid.getWidth() - 2 << "x" << grid.getHeight() - 2 << "\n";
+        return false;
+    }
+
+    int cellCount = grid.getSize();
+    int agentCount = header.agentCount;
+    if (agentCount < 0 || agentCount > cellCount || header.emptyCount < 0 || header.emptyCount > cellCount || header.foodValueCount < 0) {
+        return false;
+    }
+
+    // Разделы читаются прямо из отображения: они выровнены по 32 байта
+    SectionReader reader{data, size, sizeof(header)};
+    const uint8_t* types = reader.take(cellCount);
+    const int* foodValues = reinterpret_cast<const int*>(reader.take(cellCount * sizeof(int)));
+    const int* emptyCells = reinterpret_cast<const int*>(reader.take(header.emptyCount * sizeof(int)));
+    const int* foodValueSection = reinterpret_cast<const int*>(reader.take(header.foodValueCount * sizeof(int)));
+    const int* xs = reinterpret_cast<const int*>(reader.take(agentCount * sizeof(int)));
+    const int* ys = reinterpret_cast<const int*>(reader.take(agentCount * sizeof(int)));
+    const int* energies = reinterpret_cast<const int*>(reader.take(agentCount * sizeof(int)));
+    const int* stepCounts = reinterpret_cast<const int*>(reader.take(agentCount * sizeof(int)));
+    const uint8_t* alives = reader.take(agentCount);
+    const unsigned char* generators = reader.take(agentCount * sizeof(Random));
+    if (!types || !foodValues || !emptyCells || !foodValueSection || !xs || !ys || !energies || !stepCounts || !alives || !generators) {
+        return false;
+    }
+
+    // Гены собираются до изменения симуляции: поврежденная запись не оставит популяцию наполовину замененной
+    vector<unique_ptr<Gene>> genes;
+    genes.reserve(agentCount);
+    GenomeRecord record;
+    for (int i = 0; i < agentCount; i++) {
+        if (!grid.inBounds(xs[i], ys[i])) {
+            return false;
+        }
+        size_t recordSize = readGenomeRecord(data + reader.offset, size - reader.offset, &record);
+        if (recordSize == 0) {
+            return false;
+        }
+        reader.offset += recordSize;
+        genes.push_back(createGene(createNetwork(record)));
+    }
+    if (reader.offset != size) {
+        return false;
+    }
+
+    if (!grid.restore(types, foodValues, emptyCells, header.emptyCount)) {
+        return false;
+    }
+
+    // Индекс еды производный: собирается по полю
+    foodIndex.clear();
+    for (int i = 0; i < cellCount; i++) {
+        if (grid.getType(i) == FOOD) {
+            foodIndex.add(i % grid.getWidth(), i / grid.getWidth());
+        }
+    }
+    vacatedCells.clear();
+    FoodValue.assign(foodValueSection, foodValueSection + header.foodValueCount);
+
+    population.clear();
+    population.reserve(agentCount);
+    for (int i = 0; i < agentCount; i++) {
+        Random agentRng;
+        memcpy(&agentRng, generators + i * sizeof(Random), sizeof(Random));
+        population.add(xs[i], ys[i], energies[i], move(genes[i]), agentRng);
+        population.steps[i] = stepCounts[i];
+        population.alive[i] = alives[i] ? 1 : 0;
+    }
+
+    // Арены пересоздаются от нового поля при следующей оценке
+    arenas.clear();
+    arenaMembers.clear();
+    fitnessReady = false;
+
+    setGlobalSeed(header.seed);
+    stream = header.stream;
+    memcpy(&rng, header.rng, sizeof(header.rng));
+    generation = header.generation;
+    mutationPower = header.mutationPower;
+    totalDeaths = header.totalDeaths;
+    totalAlives = header.totalAlives;
+    currentTick = header.currentTick;
+    recountEnergy();
+
+    if (loopPosition) {
+        *loopPosition = header.loopPosition;
+    }
+    return true;
+}
+
+bool EvolutionSimulation::saveSimulationState(const string& filename, int loopPosition) const {
+    vector<unsigned char> snapshot;
+    return saveSnapshot(snapshot, loopPosition) && writeFileAtomically(filename, snapshot);
+}
+
+bool EvolutionSimulation::loadSimulationState(const string& filename, int* loopPosition) {
+    MappedFile file;
+    if (!file.open(filename, sizeof(SnapshotHeader))) {
+        cerr << "Cannot open checkpoint: " << filename << "\n";
+        return false;
+    }
+    return restoreSnapshot(file.getData(), file.getSize(), loopPosition);
+}
+
+bool writeFileAtomically(const string& path, const vector<unsigned char>& bytes) {
+    string temporary = path + ".tmp";
+
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(temporary.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    size_t written = 0;
+    while (written < bytes.size()) {
+        DWORD chunk = (DWORD)min(bytes.size() - written, (size_t)1 << 30);
+        DWORD done = 0;
+        if (!WriteFile(handle, bytes.data() + written, chunk, &done, nullptr) || done == 0) {
+            break;
+        }
+        written += done;
+    }
+    bool ok = written == bytes.size() && FlushFileBuffers(handle);
+    ok = CloseHandle(handle) && ok;
+    if (!ok) {
+        DeleteFileA(temporary.c_str());
+        return false;
+    }
+    return MoveFileExA(temporary.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    int descriptor = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (descriptor < 0) {
+        return false;
+    }
+
+    size_t written = 0;
+    while (written < bytes.size()) {
+        ssize_t done = ::write(descriptor, bytes.data() + written, bytes.size() - written);
+        if (done < 0 && errno == EINTR) {
+            continue;
+        }
+        if (done <= 0) {
+            break;
+        }
+        written += done;
+    }
+
+    // Данные должны лечь на диск до переименования, иначе после сбоя питания новый файл может оказаться пустым
+    bool ok = written == bytes.size() && fsync(descriptor) == 0;
+    ok = ::close(descriptor) == 0 && ok;
+    if (!ok) {
+        ::unlink(temporary.c_str());
+        return false;
+    }
+    return ::rename(temporary.c_str(), path.c_str()) == 0;
+#endif
+}
+
+CheckpointWriter::CheckpointWriter(const string& path, bool background)
+    : path(path), background(background), hasPending(false), busy(false), stopping(false), failures(0) {}
+
+CheckpointWriter::~CheckpointWriter() {
+    if (worker.joinable()) {
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        changed.notify_all();
+        worker.join(); // Поток допишет ожидающий снимок перед выходом
+    }
+}
+
+bool CheckpointWriter::save(const EvolutionSimulation& sim, int loopPosition) {
+    if (!sim.saveSnapshot(staging, loopPosition)) {
+        cerr << "Cannot build checkpoint snapshot\n";
+        return false;
+    }
+
+    if (!background) {
+        if (!writeFileAtomically(path, staging)) {
+            cerr << "Cannot write checkpoint: " << path << "\n";
+            failures++;
+            return false;
+        }
+        return true;
+    }
+
+    {
+        lock_guard<mutex> guard(lock);
+        swap(staging, pending); // Незаписанный прежний снимок заменяется новым
+        hasPending = true;
+        if (!worker.joinable()) {
+            worker = thread(&CheckpointWriter::run, this);
+        }
+    }
+    changed.notify_all();
+    return true;
+}
+
+void CheckpointWriter::run() {
+    unique_lock<mutex> guard(lock);
+    while (true) {
+        changed.wait(guard, [this] { return hasPending || stopping; });
+        if (!hasPending) {
+            return;
+        }
+
+        swap(pending, writing);
+        hasPending = false;
+        busy = true;
+        guard.unlock();
+
+        bool ok = writeFileAtomically(path, writing);
+
+        guard.lock();
+        busy = false;
+        if (!ok) {
+            failures++;
+            cerr << "Cannot write checkpoint: " << path << "\n";
+        }
+        changed.notify_all();
+    }
+}
+
+void CheckpointWriter::flush() {
+    unique_lock<mutex> guard(lock);
+    changed.wait(guard, [this] { return !hasPending && !busy; });
+}
+
+int CheckpointWriter::getFailureCount() {
+    lock_guard<mutex> guard(lock);
+    return failures;
+}
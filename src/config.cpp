@@ -0,0 +1,305 @@
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include "config.h"
+#include "main.h"
+
+using namespace std;
+
+bool UseNeuralNetwork = USE_A_NEURAL_NETWORK;
+bool UseFoodField = USE_FOOD_FIELD;
+bool UseBatchInference = USE_BATCH_INFERENCE;
+bool UseFixedTopology = USE_FIXED_TOPOLOGY;
+int InputValues = INPUT_VALUES;
+int NeuronsInHiddenLayer = NEURONS_IN_HIDDEN_LAYER;
+int OutputValues = OUTPUT_VALUES;
+
+int FieldWidth = FIELD_WIDTH;
+int FieldHeight = FIELD_HEIGHT;
+int Generations = GENERATIONS;
+int SkipGenerations = SKIP_GENERATIONS;
+int InitPopSize = INIT_POP_SIZE;
+int NumberOfSteps = NUMBER_OF_STEPS;
+int InitEnergyAgent = INIT_ENERGY_AGENT;
+int EnergyLossPerStep = ENERGY_LOSS_PER_STEP;
+int EnergyLossDueToInaction = ENERGY_LOSS_DUE_TO_INACTION;
+int InitFoodCount = INIT_FOOD_COUNT;
+int FoodSpawnInterval = FOOD_SPAWN_INTERVAL;
+int FoodAddTimes = FOOD_ADD_TIMES;
+float ChanceOfFoodAppearance = CHANCE_OF_FOOD_APPEARANCE;
+int EnergyFoodValue = ENERGY_FOOD_VALUE;
+int TickMs = TICK_MS;
+bool UseRenderThread = RENDER_THREAD;
+int FrameMs = FRAME_MS;
+uint64_t RandomSeed = RANDOM_SEED;
+int ArenaCount = ARENA_COUNT;
+int WorkerThreads = WORKER_THREADS;
+int IslandCount = ISLAND_COUNT;
+int MigrationInterval = MIGRATION_INTERVAL;
+int MigrantCount = MIGRANT_COUNT;
+int MigrationTopologyMode = MIGRATION_TOPOLOGY;
+float AgentMutationChance = AGENT_MUTATION_CHANCE;
+float AgentMutationPower = AGENT_MUTATION_POWER;
+float AgentChanceToCrossOver = AGENT_CHANCE_TO_CROSS_OVER;
+int SelectionSchemeMode = SELECTION_SCHEME;
+int TournamentSize = TOURNAMENT_SIZE;
+float RankPressure = RANK_PRESSURE;
+float TruncationShare = TRUNCATION_SHARE;
+bool Headless = false;
+string GenomeFile = GENOME_FILE;
+string ConvertCsvFile;
+string StatsFile = STATS_FILE;
+int StatsFlushMs = STATS_FLUSH_MS;
+string ExportStatsFile;
+string CheckpointFile = CHECKPOINT_FILE;
+int CheckpointInterval = CHECKPOINT_INTERVAL;
+bool CheckpointInBackground = CHECKPOINT_IN_BACKGROUND;
+bool Resume = false;
+string RecordDir;
+int RecordKeyframeInterval = RECORD_KEYFRAME_INTERVAL;
+string ReplayFile;
+int ReplayFrom = 0;
+int ReplayTo = -1;
+float ReplaySpeed = REPLAY_SPEED;
+
+static const double NO_LIMIT = FLT_MAX; // Верхняя граница параметров без своего максимума
+
+/**
+ * @brief Описание параметра: имя, тип, адрес переменной, допустимый диапазон и подсказка.
+ */
+struct ConfigEntry {
+    const char* name;
+    char type; // 'i' - int, 'f' - float, 'b' - bool, 'u' - uint64, 's' - строка
+    void* value;
+    double minValue;
+    double maxValue;
+    const char* help;
+};
+
+static const ConfigEntry entries[] = {
+    {"field-width",          'i', &FieldWidth,              1, NO_LIMIT, "Ширина поля"},
+    {"field-height",         'i', &FieldHeight,             1, NO_LIMIT, "Высота поля"},
+    {"generations",          'i', &Generations,             1, NO_LIMIT, "Всего поколений"},
+    {"skip-generations",     'i', &SkipGenerations,         1, NO_LIMIT, "Поколений между визуализациями"},
+    {"pop-size",             'i', &InitPopSize,             4, NO_LIMIT, "Размер популяции"},
+    {"steps",                'i', &NumberOfSteps,           1, NO_LIMIT, "Кол-во шагов в раунде"},
+    {"init-energy",          'i', &InitEnergyAgent,         1, NO_LIMIT, "Начальная энергия агента"},
+    {"energy-loss-step",     'i', &EnergyLossPerStep,       0, NO_LIMIT, "Потеря энергии за шаг"},
+    {"energy-loss-inaction", 'i', &EnergyLossDueToInaction, 0, NO_LIMIT, "Потеря энергии за бездействие"},
+    {"init-food",            'i', &InitFoodCount,           0, NO_LIMIT, "Еды в начале раунда"},
+    {"food-spawn-interval",  'i', &FoodSpawnInterval,       1, NO_LIMIT, "Еда появляется каждый N-й тик"},
+    {"food-add-times",       'i', &FoodAddTimes,            0, NO_LIMIT, "Кол-во попыток появления еды за раз"},
+    {"food-chance",          'f', &ChanceOfFoodAppearance,  0, 1,        "Шанс появления еды за попытку"},
+    {"food-value",           'i', &EnergyFoodValue,         3, NO_LIMIT, "Энергетическая ценность еды"},
+    {"food-field",           'b', &UseFoodField,            0, 1,        "Направление к еде по полю расстояний (0/1)"},
+    {"batch-inference",      'b', &UseBatchInference,       0, 1,        "Пакетный вывод нейросетей за тик (0/1)"},
+    {"fixed-topology",       'b', &UseFixedTopology,        0, 1,        "Специализированные сети для стандартных топологий (0/1)"},
+    {"tick-ms",              'i', &TickMs,                  0, NO_LIMIT, "Интервал между тиками при визуализации (мс, 0 - без пауз)"},
+    {"render-thread",        'b', &UseRenderThread,         0, 1,        "Отрисовка в отдельном потоке (0/1)"},
+    {"frame-ms",             'i', &FrameMs,                 1, NO_LIMIT, "Интервал между кадрами потока отрисовки (мс)"},
+    {"seed",                 'u', &RandomSeed,              0, NO_LIMIT, "Зерно генератора (0 - случайное)"},
+    {"arenas",               'i', &ArenaCount,              0, NO_LIMIT, "Параллельных арен для оценки (0 - выкл.)"},
+    {"threads",              'i', &WorkerThreads,           0, NO_LIMIT, "Рабочих потоков (0 - по числу ядер)"},
+    {"islands",              'i', &IslandCount,             0, NO_LIMIT, "Островов островной модели (0 - выкл.)"},
+    {"migration-interval",   'i', &MigrationInterval,       0, NO_LIMIT, "Миграция каждые N поколений"},
+    {"migrants",             'i', &MigrantCount,            0, NO_LIMIT, "Мигрантов за раз"},
+    {"topology",             'i', &MigrationTopologyMode,   0, 1,        "Топология миграции: 0 - кольцо, 1 - полносвязная"},
+    {"mutation-chance",      'f', &AgentMutationChance,     0, 1,        "Шанс мутации гена"},
+    {"mutation-power",       'f', &AgentMutationPower,      0, NO_LIMIT, "Начальная сила мутации"},
+    {"crossover-chance",     'f', &AgentChanceToCrossOver,  0, 1,        "Шанс скрещивания"},
+    {"selection",            'i', &SelectionSchemeMode,     0, 3,        "Отбор: 0 - равномерный, 1 - турнир, 2 - ранговый, 3 - усечение"},
+    {"tournament-size",      'i', &TournamentSize,          1, NO_LIMIT, "Участников турнира"},
+    {"rank-pressure",        'f', &RankPressure,            1, 2,        "Давление рангового отбора (1..2)"},
+    {"truncation-share",     'f', &TruncationShare,         0, 1,        "Доля лучших для отбора усечением"},
+    {"headless",             'b', &Headless,                0, 1,        "Без вывода в терминал и задержек: обучение, проигрывание записи текстом (0/1)"},
+    {"genome-file",          's', &GenomeFile,              0, NO_LIMIT, "Двоичный архив лучших геномов (запись при обучении, чтение при -v)"},
+    {"convert-csv",          's', &ConvertCsvFile,          0, NO_LIMIT, "Перевести CSV-архив геномов в genome-file и выйти"},
+    {"stats-file",           's', &StatsFile,               0, NO_LIMIT, "Двоичный журнал статистики по поколениям"},
+    {"stats-flush-ms",       'i', &StatsFlushMs,            0, NO_LIMIT, "Интервал записи статистики на диск (мс, 0 - сразу)"},
+    {"export-stats",         's', &ExportStatsFile,         0, NO_LIMIT, "Перевести stats-file в указанный CSV-файл и выйти"},
+    {"checkpoint-file",      's', &CheckpointFile,          0, NO_LIMIT, "Файл контрольной точки обучения"},
+    {"checkpoint-interval",  'i', &CheckpointInterval,      0, NO_LIMIT, "Контрольная точка каждые N поколений и в конце (0 - выкл., без островов)"},
+    {"checkpoint-background",'b', &CheckpointInBackground,  0, 1,        "Запись контрольных точек в фоновом потоке (0/1)"},
+    {"resume",               'b', &Resume,                  0, 1,        "Продолжить обучение с checkpoint-file (0/1)"},
+    {"record-dir",           's', &RecordDir,               0, NO_LIMIT, "Каталог для записей раундов с визуализацией (по файлу на раунд)"},
+    {"record-keyframe",      'i', &RecordKeyframeInterval,  1, NO_LIMIT, "Опорный кадр записи каждые N тиков"},
+    {"replay",               's', &ReplayFile,              0, NO_LIMIT, "Проиграть запись раунда (без нейросетей) и выйти"},
+    {"replay-from",          'i', &ReplayFrom,              0, NO_LIMIT, "Первый кадр проигрывания"},
+    {"replay-to",            'i', &ReplayTo,               -1, NO_LIMIT, "Последний кадр (-1 - последний в записи, меньше первого - назад)"},
+    {"replay-speed",         'f', &ReplaySpeed,             0, NO_LIMIT, "Скорость проигрывания относительно tick-ms (0 - без пауз)"},
+};
+
+static const ConfigEntry* findEntry(const string& key) {
+    for (const auto& entry : entries) {
+        if (key == entry.name) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+bool setConfigValue(const string& key, const string& value) {
+    const ConfigEntry* entry = findEntry(key);
+    if (!entry) {
+        return false;
+    }
+
+    if (entry->type == 's') {
+        if (value.empty()) {
+            return false;
+        }
+        *(string*)entry->value = value;
+        return true;
+    }
+
+    try {
+        // Целые разбираются целиком: "1e3" или "4.9" - ошибка, а не 1 или 4
+        size_t used = 0;
+        double number = 0;
+        unsigned long long whole = 0;
+        if (entry->type == 'f') {
+            number = stod(value, &used);
+        } else if (entry->type == 'u') {
+            if (value.find('-') != string::npos) {
+                return false; // stoull молча переворачивает отрицательные значения
+            }
+            whole = stoull(value, &used);
+            number = (double)whole;
+        } else {
+            number = (double)stoll(value, &used);
+        }
+
+        // Сравнение записано так, чтобы nan тоже не проходил
+        if (used != value.size() || !(number >= entry->minValue && number <= entry->maxValue)) {
+            return false;
+        }
+        if (entry->type == 'i' && (number < INT_MIN || number > INT_MAX)) {
+            return false;
+        }
+
+        switch (entry->type) {
+            case 'i': *(int*)entry->value = (int)number; break;
+            case 'f': *(float*)entry->value = (float)number; break;
+            case 'b': *(bool*)entry->value = number != 0; break;
+            case 'u': *(uint64_t*)entry->value = whole; break;
+        }
+    } catch (...) {
+        return false;
+    }
+
+    return true;
+}
+
+static string trim(const string& text) {
+    size_t first = text.find_first_not_of(" \t\r");
+    if (first == string::npos) {
+        return "";
+    }
+    size_t last = text.find_last_not_of(" \t\r");
+    return text.substr(first, last - first + 1);
+}
+
+bool loadConfigFile(const string& path) {
+    ifstream file(path);
+    if (!file.is_open()) {
+        cerr << "Cannot open config file: " << path << "\n";
+        return false;
+    }
+
+    string line;
+    int lineNumber = 0;
+    while (getline(file, line)) {
+        lineNumber++;
+
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty()) {
+            continue;
+        }
+
+        size_t eq = line.find('=');
+        if (eq == string::npos || !setConfigValue(trim(line.substr(0, eq)), trim(line.substr(eq + 1)))) {
+            cerr << path << ":" << lineNumber << ": invalid setting: " << line << "\n";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Проверяет сочетания параметров, которые нельзя проверить по одному.
+ */
+static bool validateConfig() {
+    // Агенты и начальная еда занимают разные клетки поля
+    long long cells = (long long)FieldWidth * FieldHeight;
+    if (InitPopSize + (long long)InitFoodCount > cells) {
+        cerr << "pop-size " << InitPopSize << " and init-food " << InitFoodCount << " do not fit into a "
+             << FieldWidth << "x" << FieldHeight << " field\n";
+        return false;
+    }
+
+    // Энергия агента - int: вся еда раунда, съеденная одним агентом, не должна его переполнять
+    long long foodPerRound = InitFoodCount + (long long)FoodAddTimes * (NumberOfSteps / FoodSpawnInterval);
+    if ((long long)EnergyFoodValue * max(foodPerRound, 1LL) + InitEnergyAgent > INT_MAX) {
+        cerr << "food-value " << EnergyFoodValue << " is too large for " << foodPerRound << " food per round\n";
+        return false;
+    }
+
+    return true;
+}
+
+bool parseArguments(int argc, char* argv[], char& type) {
+    type = 't';
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+
+        if (arg == "-v") {
+            type = 'v';
+        } else if (arg == "--config") {
+            if (i + 1 >= argc || !loadConfigFile(argv[++i])) {
+                return false;
+            }
+        } else if (arg.rfind("--", 0) == 0) {
+            string key = arg.substr(2);
+            string value;
+
+            size_t eq = key.find('=');
+            if (eq != string::npos) {
+                value = key.substr(eq + 1);
+                key = key.substr(0, eq);
+            } else {
+                // Параметр (0/1) без значения - флаг: "--headless", "--resume -v"
+                const ConfigEntry* entry = findEntry(key);
+                if (entry && entry->type == 'b' && (i + 1 >= argc || argv[i + 1][0] == '-')) {
+                    value = "1";
+                } else if (i + 1 < argc) {
+                    value = argv[++i];
+                }
+            }
+
+            if (!setConfigValue(key, value)) {
+                cerr << "Invalid option: " << arg << (value.empty() ? "" : " " + value) << "\n";
+                return false;
+            }
+        } else {
+            cerr << "Unknown argument: " << arg << "\n";
+            return false;
+        }
+    }
+
+    return validateConfig();
+}
+
+void printUsage(const char* program) {
+    cout << "Usage: " << program << " [-v] [--headless [0/1]] [--resume [0/1]] [--config <file>] [--<option> <value>]...\n\n";
+    cout << "Options (also accepted as \"option = value\" lines in a config file; (0/1) options without a value mean 1):\n";
+
+    for (const auto& entry : entries) {
+        string name = entry.name;
+        cout << "  --" << name << string(name.size() < 22 ? 22 - name.size() : 1, ' ') << entry.help << "\n";
+    }
+}
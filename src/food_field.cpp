@@ -0,0 +1,65 @@
+#include "food_field.h"
+
+using namespace std;
+
+FoodField::FoodField() : width(0), height(0), stale(true) {}
+
+FoodField::FoodField(int width, int height)
+    : width(width), height(height),
+      distances(width * height, -1),
+      sources(width * height, -1),
+      queue(width * height),
+      stale(true)
+{
+}
+
+void FoodField::build(const Grid& grid) {
+    const vector<uint8_t>& types = grid.getTypes();
+    int size = width * height;
+    int head = 0, tail = 0;
+
+    // Источники - все клетки с едой
+    for (int i = 0; i < size; i++) {
+        if (types[i] == FOOD) {
+            distances[i] = 0;
+            sources[i] = i;
+            queue[tail++] = i;
+        } else {
+            distances[i] = -1;
+            sources[i] = -1;
+        }
+    }
+
+    // Соседи в том же порядке, что и при осмотре агентом: вверх, влево, вправо, вниз
+    const int offsets[4] = {-width, -1, 1, width};
+
+    while (head < tail) {
+        int cell = queue[head++];
+
+        for (int offset : offsets) {
+            int next = cell + offset;
+
+            // Поле окружено стенами, поэтому соседи проходимых клеток не выходят за буфер
+            if (types[next] == WALL || distances[next] != -1) {
+                continue;
+            }
+
+            distances[next] = distances[cell] + 1;
+            sources[next] = sources[cell];
+            queue[tail++] = next;
+        }
+    }
+
+    stale = false;
+}
+
+bool FoodField::getNearest(int x, int y, int& foodX, int& foodY) const {
+    int source = sources[y * width + x];
+    if (source == -1) {
+        return false;
+    }
+
+    foodX = source % width;
+    foodY = source / width;
+    return true;
+}
@@ -0,0 +1,116 @@
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include "food_index.h"
+
+using namespace std;
+
+FoodIndex::FoodIndex() : width(0), height(0), bucketsX(0), bucketsY(0), count(0) {}
+
+FoodIndex::FoodIndex(int width, int height)
+    : width(width), height(height),
+      bucketsX((width + BUCKET_SIZE - 1) / BUCKET_SIZE),
+      bucketsY((height + BUCKET_SIZE - 1) / BUCKET_SIZE),
+      buckets(bucketsX * bucketsY),
+      slots(width * height, -1),
+      count(0)
+{
+    // В корзине не больше BUCKET_SIZE * BUCKET_SIZE клеток, добавление еды не выделяет память
+    for (auto& bucket : buckets) {
+        bucket.reserve(BUCKET_SIZE * BUCKET_SIZE);
+    }
+}
+
+void FoodIndex::add(int x, int y) {
+    int cell = y * width + x;
+    if (slots[cell] != -1) {
+        return;
+    }
+
+    auto& bucket = buckets[bucketOf(x, y)];
+    slots[cell] = bucket.size();
+    bucket.push_back(cell);
+    count++;
+}
+
+void FoodIndex::remove(int x, int y) {
+    int cell = y * width + x;
+    int slot = slots[cell];
+    if (slot == -1) {
+        return;
+    }
+
+    // Удаление перестановкой с последним элементом корзины
+    auto& bucket = buckets[bucketOf(x, y)];
+    int last = bucket.back();
+    bucket[slot] = last;
+    slots[last] = slot;
+    bucket.pop_back();
+    slots[cell] = -1;
+    count--;
+}
+
+void FoodIndex::clear() {
+    for (auto& bucket : buckets) {
+        for (int cell : bucket) {
+            slots[cell] = -1;
+        }
+        bucket.clear();
+    }
+    count = 0;
+}
+
+bool FoodIndex::findNearest(int x, int y, int& foodX, int& foodY) const {
+    if (count == 0) {
+        return false;
+    }
+
+    int bx = x / BUCKET_SIZE;
+    int by = y / BUCKET_SIZE;
+    int maxRing = max(max(bx, bucketsX - 1 - bx), max(by, bucketsY - 1 - by));
+
+    int best = INT_MAX;
+    int bestX = 0, bestY = 0;
+
+    for (int r = 0; r <= maxRing; r++) {
+        // Любая клетка кольца r отстоит от агента минимум на (r - 1) * BUCKET_SIZE + 1
+        if (r > 0 && (r - 1) * BUCKET_SIZE + 1 > best) {
+            break;
+        }
+
+        for (int cy = max(0, by - r); cy <= min(bucketsY - 1, by + r); cy++) {
+            bool edgeRow = abs(cy - by) == r;
+            int step = edgeRow ? 1 : 2 * r; // Внутри кольца берем только крайние корзины строки
+
+            for (int cx = bx - r; cx <= bx + r; cx += step) {
+                if (cx < 0 || cx >= bucketsX) {
+                    continue;
+                }
+
+                // Нижняя граница расстояния до прямоугольника корзины
+                int left = cx * BUCKET_SIZE, right = left + BUCKET_SIZE - 1;
+                int top = cy * BUCKET_SIZE, bottom = top + BUCKET_SIZE - 1;
+                int bound = max(0, max(left - x, x - right)) + max(0, max(top - y, y - bottom));
+                if (bound > best) {
+                    continue;
+                }
+
+                for (int cell : buckets[cy * bucketsX + cx]) {
+                    int fx = cell % width;
+                    int fy = cell / width;
+                    int distance = abs(fx - x) + abs(fy - y);
+
+                    if (distance < best || (distance == best && (fx < bestX || (fx == bestX && fy < bestY)))) {
+                        best = distance;
+                        bestX = fx;
+                        bestY = fy;
+                    }
+                }
+            }
+        }
+    }
+
+    foodX = bestX;
+    foodY = bestY;
+    return true;
+}
@@ -0,0 +1,70 @@
+#include "gene_factory.h"
+#include "fixed_neural_gene.h"
+#include "main.h"
+
+using namespace std;
+
+/**
+ * @brief Описание специализации: топология и способы создать ген.
+ */
+struct FixedTopology {
+    int inputs, hidden, outputs;
+    unique_ptr<Gene> (*random)(Random& rng);
+    bool (*matches)(const NeuralNetwork& network);
+    unique_ptr<Gene> (*fromNetwork)(const NeuralNetwork& network);
+};
+
+template <int In, int Hidden, int Out>
+static FixedTopology fixedTopology() {
+    using FixedGene = FixedNeuralGene<In, Hidden, Out>;
+    return {
+        In, Hidden, Out,
+        [](Random& rng) -> unique_ptr<Gene> { return make_unique<FixedGene>(rng); },
+        [](const NeuralNetwork& network) { return FixedGene::matches(network); },
+        [](const NeuralNetwork& network) -> unique_ptr<Gene> { return make_unique<FixedGene>(network); },
+    };
+}
+
+// Топологии, под которые собираются специализации (6 и 7 входов - без и с близостью еды)
+static const FixedTopology topologies[] = {
+    fixedTopology<6, 5, 4>(),
+    fixedTopology<7, 5, 4>(),
+    fixedTopology<6, 8, 4>(),
+    fixedTopology<7, 8, 4>(),
+};
+
+static const FixedTopology* findTopology(int inputs, int hidden, int outputs) {
+    if (!UseFixedTopology) {
+        return nullptr;
+    }
+
+    for (const auto& topology : topologies) {
+        if (topology.inputs == inputs && topology.hidden == hidden && topology.outputs == outputs) {
+            return &topology;
+        }
+    }
+    return nullptr;
+}
+
+bool hasFixedTopology(int inputs, int hidden, int outputs) {
+    return findTopology(inputs, hidden, outputs) != nullptr;
+}
+
+unique_ptr<Gene> createRandomGene(Random& rng) {
+    const FixedTopology* topology = findTopology(InputValues, NeuronsInHiddenLayer, OutputValues);
+    if (topology) {
+        return topology->random(rng);
+    }
+    return make_unique<NeuralGene>(rng);
+}
+
+unique_ptr<Gene> createGene(unique_ptr<NeuralNetwork> network) {
+    const auto& layers = network->getLayers();
+    if (layers.size() == 2 && layers[0]->getInputSize() == InputValues) {
+        const FixedTopology* topology = findTopology(layers[0]->getInputSize(), layers[0]->getOutputSize(), layers[1]->getOutputSize());
+        if (topology && topology->matches(*network)) {
+            return topology->fromNetwork(*network);
+        }
+    }
+    return make_unique<NeuralGene>(move(network));
+}
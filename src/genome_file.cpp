@@ -0,0 +1,397 @@
+#include <cstring>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include "genome_file.h"
+
+using namespace std;
+
+static const char FILE_MAGIC[4] = {'A', 'G', 'N', 'M'};
+static const char RECORD_MAGIC[4] = {'G', 'R', 'E', 'C'};
+static const uint32_t FORMAT_VERSION = 1;
+static const size_t ALIGNMENT = 32;
+static const uint32_t MAX_LAYERS = 64;
+static const uint32_t MAX_LAYER_SIZE = 1 << 16;
+
+struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t alignment;
+    uint32_t reserved[5];
+};
+
+struct RecordHeader {
+    char magic[4];
+    uint32_t size;           // Размер записи вместе с заголовком
+    uint32_t layerCount;
+    int32_t generation;
+    int32_t averageEnergy;
+    uint32_t reserved;
+    uint64_t checksum;       // FNV-1a по байтам записи после заголовка
+};
+
+struct LayerHeader {
+    uint32_t inputSize;
+    uint32_t outputSize;
+    uint32_t stride;
+    uint32_t activation;
+};
+
+static_assert(sizeof(FileHeader) == 32, "genome file header must be 32 bytes");
+static_assert(sizeof(RecordHeader) == 32, "genome record header must be 32 bytes");
+static_assert(sizeof(LayerHeader) == 16, "genome layer header must be 16 bytes");
+
+static size_t alignUp(size_t bytes) { return (bytes + ALIGNMENT - 1) & ~(ALIGNMENT - 1); }
+
+/**
+ * @brief Размер параметров слоя в байтах: веса [выход][stride] и смещения, дополненные до 8 чисел.
+ */
+static size_t layerBytes(uint32_t outputSize, uint32_t stride) {
+    return ((size_t)outputSize * stride + paddedStride(outputSize)) * sizeof(float);
+}
+
+uint64_t fnv1a(const unsigned char* bytes, size_t count) {
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < count; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+size_t readGenomeRecord(const unsigned char* bytes, size_t available, GenomeRecord* record) {
+    RecordHeader header;
+    if (available < sizeof(header)) {
+        return 0;
+    }
+    memcpy(&header, bytes, sizeof(header));
+
+    if (memcmp(header.magic, RECORD_MAGIC, 4) != 0 || header.size > available || header.size % ALIGNMENT != 0
+        || header.layerCount == 0 || header.layerCount > MAX_LAYERS) {
+        return 0;
+    }
+
+    size_t tableSize = alignUp(header.layerCount * sizeof(LayerHeader));
+    if (header.size < sizeof(header) + tableSize) {
+        return 0;
+    }
+
+    const unsigned char* table = bytes + sizeof(header);
+    size_t expected = sizeof(header) + tableSize;
+    uint32_t previousOutput = 0;
+    for (uint32_t l = 0; l < header.layerCount; l++) {
+        LayerHeader layer;
+        memcpy(&layer, table + l * sizeof(layer), sizeof(layer));
+
+        if (layer.inputSize == 0 || layer.inputSize > MAX_LAYER_SIZE || layer.outputSize == 0 || layer.outputSize > MAX_LAYER_SIZE
+            || layer.stride != (uint32_t)paddedStride(layer.inputSize) || layer.activation > ACTIVATION_SIGMOID
+            || (l > 0 && layer.inputSize != previousOutput)) {
+            return 0;
+        }
+        previousOutput = layer.outputSize;
+        expected += layerBytes(layer.outputSize, layer.stride);
+    }
+
+    if (expected != header.size) {
+        return 0;
+    }
+
+    if (record) {
+        record->generation = header.generation;
+        record->averageEnergy = header.averageEnergy;
+        record->layers.clear();
+
+        const unsigned char* parameters = table + tableSize;
+        for (uint32_t l = 0; l < header.layerCount; l++) {
+            LayerHeader layer;
+            memcpy(&layer, table + l * sizeof(layer), sizeof(layer));
+
+            // Записи выровнены по 32 байта, поэтому веса можно читать прямо из отображения
+            const float* weights = reinterpret_cast<const float*>(parameters);
+            const float* biases = weights + (size_t)layer.outputSize * layer.stride;
+            record->layers.push_back({(int)layer.inputSize, (int)layer.outputSize, (int)layer.stride, weights, biases, (Activation)layer.activation});
+            parameters += layerBytes(layer.outputSize, layer.stride);
+        }
+    }
+
+    return header.size;
+}
+
+GenomeArchive::GenomeArchive() : validSize(0) {}
+
+bool GenomeArchive::open(const string& path) {
+    close();
+
+    if (!file.open(path, sizeof(FileHeader))) {
+        return false;
+    }
+    const unsigned char* data = file.getData();
+    size_t size = file.getSize();
+
+    FileHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, FILE_MAGIC, 4) != 0 || header.version != FORMAT_VERSION || header.alignment != ALIGNMENT) {
+        close();
+        return false;
+    }
+
+    // Оглавление: проходим только по заголовкам, недописанная запись в конце отбрасывается
+    size_t offset = sizeof(header);
+    while (offset < size) {
+        size_t recordSize = readGenomeRecord(data + offset, size - offset, nullptr);
+        if (recordSize == 0) {
+            break;
+        }
+        offsets.push_back(offset);
+        offset += recordSize;
+    }
+    validSize = offset;
+
+    return true;
+}
+
+void GenomeArchive::close() {
+    file.close();
+    validSize = 0;
+    offsets.clear();
+}
+
+GenomeRecord GenomeArchive::getRecord(int index) const {
+    GenomeRecord record{};
+    size_t offset = offsets[index];
+    readGenomeRecord(file.getData() + offset, file.getSize() - offset, &record);
+    return record;
+}
+
+bool GenomeArchive::verify(int index) const {
+    const unsigned char* record = file.getData() + offsets[index];
+    RecordHeader header;
+    memcpy(&header, record, sizeof(header));
+    return fnv1a(record + sizeof(header), header.size - sizeof(header)) == header.checksum;
+}
+
+bool GenomeWriter::open(const string& path) {
+    error_code error;
+    uintmax_t existing = filesystem::exists(path, error) ? filesystem::file_size(path, error) : 0;
+    if (error) {
+        existing = 0;
+    }
+
+    if (existing >= sizeof(FileHeader)) {
+        GenomeArchive archive;
+        if (!archive.open(path)) {
+            cerr << "Not a genome archive: " << path << "\n";
+            return false;
+        }
+        size_t valid = archive.getValidSize();
+        archive.close();
+
+        // Отрезаем недописанный хвост, чтобы новые записи шли сразу за последней целой
+        if (valid < existing) {
+            filesystem::resize_file(path, valid, error);
+            if (error) {
+                cerr << "Cannot repair genome archive: " << path << "\n";
+                return false;
+            }
+        }
+        file.open(path, ios::binary | ios::app);
+    } else {
+        // Нового или оборванного на заголовке файла - начинаем заново
+        file.open(path, ios::binary | ios::trunc);
+        FileHeader header{};
+        memcpy(header.magic, FILE_MAGIC, 4);
+        header.version = FORMAT_VERSION;
+        header.alignment = ALIGNMENT;
+        file.write((const char*)&header, sizeof(header));
+        file.flush();
+    }
+
+    return file.good();
+}
+
+size_t appendGenomeRecord(vector<unsigned char>& out, const vector<LayerView>& layers, int generation, int averageEnergy) {
+    if (layers.empty() || layers.size() > MAX_LAYERS) {
+        return 0;
+    }
+
+    size_t tableSize = alignUp(layers.size() * sizeof(LayerHeader));
+    size_t recordSize = sizeof(RecordHeader) + tableSize;
+    for (const LayerView& layer : layers) {
+        recordSize += layerBytes(layer.outputSize, layer.stride);
+    }
+
+    size_t start = out.size();
+    out.resize(start + recordSize, 0);
+    unsigned char* record = out.data() + start;
+    unsigned char* table = record + sizeof(RecordHeader);
+    unsigned char* parameters = table + tableSize;
+
+    for (size_t l = 0; l < layers.size(); l++) {
+        const LayerView& layer = layers[l];
+        LayerHeader header{(uint32_t)layer.inputSize, (uint32_t)layer.outputSize, (uint32_t)layer.stride, (uint32_t)layer.activation};
+        memcpy(table + l * sizeof(header), &header, sizeof(header));
+
+        // Раскладка весов в файле та же, что в памяти, хвосты строк уже нулевые
+        size_t weightBytes = (size_t)layer.outputSize * layer.stride * sizeof(float);
+        memcpy(parameters, layer.weights, weightBytes);
+        memcpy(parameters + weightBytes, layer.biases, layer.outputSize * sizeof(float));
+        parameters += layerBytes(layer.outputSize, layer.stride);
+    }
+
+    RecordHeader header{};
+    memcpy(header.magic, RECORD_MAGIC, 4);
+    header.size = recordSize;
+    header.layerCount = layers.size();
+    header.generation = generation;
+    header.averageEnergy = averageEnergy;
+    header.checksum = fnv1a(table, recordSize - sizeof(header));
+    memcpy(record, &header, sizeof(header));
+
+    // Запись проверяется чтением своего же заголовка: неверная топология не попадет в файл
+    if (readGenomeRecord(record, recordSize, nullptr) != recordSize) {
+        out.resize(start);
+        return 0;
+    }
+    return recordSize;
+}
+
+bool GenomeWriter::write(const vector<LayerView>& layers, int generation, int averageEnergy) {
+    if (!file.is_open()) {
+        return false;
+    }
+
+    buffer.clear();
+    if (appendGenomeRecord(buffer, layers, generation, averageEnergy) == 0) {
+        return false;
+    }
+
+    file.write((const char*)buffer.data(), buffer.size());
+    file.flush();
+    return file.good();
+}
+
+bool GenomeWriter::write(const Gene& gene, int generation, int averageEnergy) {
+    vector<LayerView> layers;
+    for (int l = 0; l < gene.getLayerCount(); l++) {
+        layers.push_back(gene.getLayer(l));
+    }
+    return write(layers, generation, averageEnergy);
+}
+
+unique_ptr<NeuralNetwork> createNetwork(const GenomeRecord& record) {
+    auto network = make_unique<NeuralNetwork>();
+    for (const LayerView& layer : record.layers) {
+        network->addLayer(make_unique<GeneLayer>(layer));
+    }
+    return network;
+}
+
+int convertCsvToGenomes(const string& csvPath, const string& genomePath) {
+    ifstream input(csvPath);
+    if (!input.is_open()) {
+        cerr << "Cannot open CSV file: " << csvPath << "\n";
+        return -1;
+    }
+
+    GenomeWriter writer;
+    if (!writer.open(genomePath)) {
+        return -1;
+    }
+
+    string line;
+    int lineNumber = 0;
+    int converted = 0;
+    bool pending = false; // В line уже прочитан заголовок следующей записи
+
+    while (pending || getline(input, line)) {
+        if (!pending) {
+            lineNumber++;
+        }
+        pending = false;
+
+        // Запись начинается со строки заголовка NeuralGene::saveDataCSV
+        if (line.rfind("InputValues", 0) != 0) {
+            continue;
+        }
+
+        if (!getline(input, line)) {
+            break;
+        }
+        lineNumber++;
+
+        stringstream topology(line);
+        string field;
+        vector<string> fields;
+        while (getline(topology, field, ';')) {
+            fields.push_back(field);
+        }
+
+        int inputs = 0, hidden = 0, outputs = 0;
+        if (fields.size() >= 5) {
+            inputs = atoi(fields[0].c_str());
+            hidden = atoi(fields[1].c_str());
+            outputs = atoi(fields[2].c_str());
+        }
+        if (inputs <= 0 || hidden <= 0 || outputs <= 0) {
+            cerr << csvPath << ":" << lineNumber << ": invalid topology: " << line << "\n";
+            return -1;
+        }
+
+        GeneLayer layer1(inputs, hidden, fields[3]);
+        GeneLayer layer2(hidden, outputs, fields[4]);
+
+        // Порядок значений: веса [вход][выход] и смещения каждого слоя
+        bool complete = true;
+        auto readValue = [&](float& value) {
+            if (!complete || !getline(input, line)) {
+                complete = false;
+                return;
+            }
+            lineNumber++;
+
+            char* end = nullptr;
+            value = strtof(line.c_str(), &end);
+            if (end == line.c_str()) {
+                complete = false;
+            }
+        };
+
+        for (GeneLayer* layer : {&layer1, &layer2}) {
+            float* weights = layer->getWeightData();
+            int stride = layer->getStride();
+            for (int i = 0; i < layer->getInputSize(); i++) {
+                for (int o = 0; o < layer->getOutputSize(); o++) {
+                    readValue(weights[o * stride + i]);
+                }
+            }
+            for (float& bias : layer->getBiases()) {
+                readValue(bias);
+            }
+        }
+
+        if (!complete) {
+            cerr << csvPath << ":" << lineNumber << ": record is incomplete\n";
+            return -1;
+        }
+
+        // За весами идет строка "поколение средняя_энергия" (в старых файлах ее может не быть)
+        int generation = 0, averageEnergy = 0;
+        if (getline(input, line)) {
+            lineNumber++;
+            stringstream trailer(line);
+            if (!(trailer >> generation >> averageEnergy)) {
+                generation = averageEnergy = 0;
+                pending = true;
+            }
+        }
+
+        if (!writer.write({layer1.view(), layer2.view()}, generation, averageEnergy)) {
+            cerr << "Cannot write genome archive: " << genomePath << "\n";
+            return -1;
+        }
+        converted++;
+    }
+
+    return converted;
+}
@@ -0,0 +1,106 @@
+#include <algorithm>
+#include "grid.h"
+
+using namespace std;
+
+Grid::Grid() : width(0), height(0), typeCounts{0, 0, 0, 0} {}
+
+Grid::Grid(int innerWidth, int innerHeight)
+    : width(innerWidth + 2), height(innerHeight + 2),
+      types((innerWidth + 2) * (innerHeight + 2), EMPTY),
+      foodValues((innerWidth + 2) * (innerHeight + 2), 0),
+      emptySlots((innerWidth + 2) * (innerHeight + 2), -1),
+      dirtyFlags((innerWidth + 2) * (innerHeight + 2), 0)
+{
+    // Задаем стены на границах (напрямую в плоскость, список пустых клеток собирается после)
+    for (int x = 0; x < width; x++) {
+        types[index(x, 0)] = WALL;          // Верхняя граница
+        types[index(x, height - 1)] = WALL; // Нижняя граница
+    }
+
+    for (int y = 0; y < height; y++) {
+        types[index(0, y)] = WALL;          // Левая граница
+        types[index(width - 1, y)] = WALL;  // Правая граница
+    }
+
+    // Стены тоже изменения - их должна нарисовать отрисовка
+    for (int i = 0; i < getSize(); i++) {
+        if (types[i] == WALL) {
+            markDirty(i);
+        }
+    }
+
+    rebuildIndex();
+}
+
+void Grid::clear() {
+    for (int i = 0; i < getSize(); i++) {
+        if (types[i] != WALL) {
+            if (types[i] != EMPTY) {
+                markDirty(i);
+            }
+            types[i] = EMPTY;
+            foodValues[i] = 0;
+        }
+    }
+
+    rebuildIndex();
+}
+
+bool Grid::restore(const uint8_t* newTypes, const int* newFoodValues, const int* newEmptyCells, int emptyCount) {
+    for (int i = 0; i < getSize(); i++) {
+        if (newTypes[i] > AGENT) {
+            clear();
+            return false;
+        }
+        types[i] = newTypes[i];
+        foodValues[i] = newFoodValues[i];
+        markDirty(i);
+    }
+
+    // Счетчики и отметки пустых клеток собираются заново, затем порядок списка подменяется сохраненным
+    rebuildIndex();
+    if (emptyCount != (int)emptyCells.size()) {
+        clear();
+        return false;
+    }
+
+    fill(emptySlots.begin(), emptySlots.end(), -1);
+    for (int k = 0; k < emptyCount; k++) {
+        int cell = newEmptyCells[k];
+        if (cell < 0 || cell >= getSize() || types[cell] != EMPTY || emptySlots[cell] != -1) {
+            clear();
+            return false;
+        }
+        emptyCells[k] = cell;
+        emptySlots[cell] = k;
+    }
+
+    return true;
+}
+
+void Grid::rebuildIndex() {
+    // Списки не длиннее поля: резервируем сразу, чтобы тики не перевыделяли память (в том числе у копий поля)
+    emptyCells.reserve(getSize());
+    dirtyCells.reserve(getSize());
+
+    emptyCells.clear();
+    fill(begin(typeCounts), end(typeCounts), 0);
+
+    for (int i = 0; i < getSize(); i++) {
+        typeCounts[types[i]]++;
+        if (types[i] == EMPTY) {
+            emptySlots[i] = emptyCells.size();
+            emptyCells.push_back(i);
+        } else {
+            emptySlots[i] = -1;
+        }
+    }
+}
+
+void Grid::clearDirty() {
+    for (int i : dirtyCells) {
+        dirtyFlags[i] = 0;
+    }
+    dirtyCells.clear();
+}
@@ -0,0 +1,110 @@
+#include <algorithm>
+#include "island_model.h"
+#include "thread_pool.h"
+
+using namespace std;
+
+IslandModel::IslandModel(const Grid& field, IslandSettings settings) : settings(settings) {
+    for (int i = 0; i < settings.islandCount; i++) {
+        auto island = make_unique<Island>();
+        island->sim = make_unique<EvolutionSimulation>(field, InitPopSize, InitFoodCount, i + 1); // У каждого острова свой поток случайных чисел
+        island->inbox.store(nullptr);
+        islands.push_back(move(island));
+    }
+}
+
+IslandModel::~IslandModel() {
+    // Удаляем мигрантов, которых никто не забрал
+    for (auto& island : islands) {
+        MigrantBatch* batch = island->inbox.exchange(nullptr);
+        while (batch) {
+            MigrantBatch* next = batch->next;
+            delete batch;
+            batch = next;
+        }
+    }
+}
+
+void IslandModel::run(int generations, const function<void(int, EvolutionSimulation&)>& onGeneration) {
+    ThreadPool pool(islands.size()); // По потоку на остров, острова не ждут друг друга
+
+    for (int i = 0; i < (int)islands.size(); i++) {
+        pool.submit([this, i, generations, &onGeneration] {
+            runIsland(i, generations, onGeneration);
+        });
+    }
+
+    pool.wait();
+}
+
+void IslandModel::runIsland(int index, int generations, const function<void(int, EvolutionSimulation&)>& onGeneration) {
+    EvolutionSimulation& sim = *islands[index]->sim;
+
+    for (int gen = 1; gen <= generations; gen++) {
+        for (int step = 1; step <= NumberOfSteps; step++) {
+            if (!sim.simulateStep()) { break; }
+        }
+
+        sim.sortPop(settings.migrantCount, settings.migrantCount); // Мигранты - лучшие, заменяются худшие
+        if (onGeneration) {
+            onGeneration(index, sim);
+        }
+
+        if (settings.migrationInterval > 0 && gen % settings.migrationInterval == 0) {
+            emigrate(index);
+            immigrate(index);
+        }
+
+        sim.geneticAlgorithm();
+        sim.reloadGrid();
+    }
+}
+
+void IslandModel::emigrate(int index) {
+    int count = islands.size();
+    if (count < 2) {
+        return;
+    }
+
+    const EvolutionSimulation& sim = *islands[index]->sim;
+
+    for (int offset = 1; offset < count; offset++) {
+        int target = (index + offset) % count;
+
+        auto batch = new MigrantBatch{sim.cloneBestGenes(settings.migrantCount), nullptr};
+        push(target, batch);
+
+        if (settings.topology == RING) {
+            break; // В кольце только следующий остров
+        }
+    }
+}
+
+void IslandModel::push(int index, MigrantBatch* batch) {
+    atomic<MigrantBatch*>& inbox = islands[index]->inbox;
+
+    batch->next = inbox.load(memory_order_relaxed);
+    while (!inbox.compare_exchange_weak(batch->next, batch, memory_order_release, memory_order_relaxed)) {
+        // batch->next обновлен текущей вершиной стека, повторяем
+    }
+}
+
+void IslandModel::immigrate(int index) {
+    // Забираем весь стек разом - потребитель у стека один, поэтому ABA не возникает
+    MigrantBatch* batch = islands[index]->inbox.exchange(nullptr, memory_order_acquire);
+
+    vector<unique_ptr<Gene>> migrants;
+    while (batch) {
+        for (auto& gene : batch->genes) {
+            migrants.push_back(move(gene));
+        }
+
+        MigrantBatch* next = batch->next;
+        delete batch;
+        batch = next;
+    }
+
+    if (!migrants.empty()) {
+        islands[index]->sim->replaceWorstGenes(migrants);
+    }
+}
@@ -1,98 +1,42 @@
 #include <thread>
 #include <chrono>
+#include <cstdio>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <algorithm>
 #include <string>
 #include <sstream>
 #include <memory>
+#include <mutex>
 #include "main.h"
+#include "config.h"
+#include "alloc_counter.h"
+#include "checkpoint.h"
+#include "genome_file.h"
+#include "island_model.h"
+#include "recording.h"
 #include "streamout.h"
 #include "simulation.h"
+#include "stats_sink.h"
 
-bool UseNeuralNetwork = USE_A_NEURAL_NETWORK;
-int InputValues = INPUT_VALUES;
-int NeuronsInHiddenLayer = NEURONS_IN_HIDDEN_LAYER;
-int OutputValues = OUTPUT_VALUES;
-
-ProgramParameters parseFile(ProgramParameters param) {
-    std::ifstream file("simulation_data.csv");
-    
-    if (!file.is_open()) {
-        return param;
-    }
-
-    std::string line;
-    
-    // Пропускаем первую строку с заголовком
-    if (!std::getline(file, line)) {
-        return param;
+/**
+ * @brief Загружает последнюю (самую обученную) сеть из архива геномов.
+ */
+unique_ptr<NeuralNetwork> loadTrainedNetwork(const string& path) {
+    GenomeArchive archive;
+    if (!archive.open(path) || archive.getRecordCount() == 0) {
+        cerr << "No genomes in " << path << " (CSV archives can be converted with --convert-csv)\n";
+        return nullptr;
     }
 
-    // Читаем вторую строку с параметрами сети
-    if (!std::getline(file, line)) {
-        return param;
+    int last = archive.getRecordCount() - 1;
+    if (!archive.verify(last)) {
+        cerr << "Genome record " << last << " in " << path << " is corrupted\n";
+        return nullptr;
     }
 
-    std::istringstream ss(line);
-    std::string value;
-    std::vector<std::string> values;
-    
-    while (std::getline(ss, value, ';')) {
-        values.push_back(value);
-    }
-    
-    if (values.size() >= 5) {
-        param.useNeuralNetwork = true;
-        param.InputValues = std::stoi(values[0]);
-        param.NeuronsInHiddenLayer = std::stoi(values[1]);
-        param.OutputValues = std::stoi(values[2]);
-        param.activationMid = values[3];
-        param.activationLast = values[4];
-    }
-
-    // Читаем все веса и смещения
-    std::vector<float> weightsBiases;
-    while (std::getline(file, line)) {
-        weightsBiases.push_back((float)std::stod(line));
-    }
-
-    // Рассчитываем ожидаемое количество параметров
-    const int expectedC = param.InputValues * param.NeuronsInHiddenLayer +     // веса 1 слоя
-                             param.NeuronsInHiddenLayer +                      // смещения 1 слоя
-                             param.NeuronsInHiddenLayer * param.OutputValues + // веса 2 слоя
-                             param.OutputValues;                               // смещения 2 слоя
-    
-    if (weightsBiases.size() != expectedC) {
-        // Если кол-во параметров не совпадает
-        return param;
-    }
-
-    auto point = weightsBiases.begin();
-    
-    // Веса первого слоя
-    std::vector<float> layer1_w;
-    layer1_w.insert(layer1_w.end(), point, point + param.InputValues * param.NeuronsInHiddenLayer);
-    point += param.InputValues * param.NeuronsInHiddenLayer;
-    
-    // Смещения первого слоя
-    std::vector<float> layer1_b;
-    layer1_b.insert(layer1_b.end(), point, point + param.NeuronsInHiddenLayer);
-    point += param.NeuronsInHiddenLayer;
-    
-    // Веса второго слоя
-    std::vector<float> layer2_w;
-    layer2_w.insert(layer2_w.end(), point, point + param.NeuronsInHiddenLayer * param.OutputValues);
-    point += param.NeuronsInHiddenLayer * param.OutputValues;
-    
-    // Смещения второго слоя
-    std::vector<float> layer2_b;
-    layer2_b.insert(layer2_b.end(), point, point + param.OutputValues);
-    
-    param.weights = {layer1_w, layer2_w};
-    param.biases = {layer1_b, layer2_b};
-    
-    return param;
+    return createNetwork(archive.getRecord(last));
 }
 
 void settingConstants(ProgramParameters param) {
@@ -102,114 +46,454 @@ void settingConstants(ProgramParameters param) {
     OutputValues = param.OutputValues;
 }
 
-void saveStatistic(std::ofstream& file, EvolutionSimulation& sim, char typeSave) {
+void saveStatistic(StatsSink& stats, EvolutionSimulation& sim, int island = 0) {
     // Краткая информация
-    if (typeSave == 's') {
-        file << sim.getGeneration() << ";" << sim.getSimulationData().averageEnergyLevel << ";" << sim.getPopulation()[0]->getSteps() << ";" << sim.getSimulationData().totalAlives << std::endl;
-        file.flush();
+    const auto data = sim.getSimulationData();
+    stats.add({island, data.generation, data.averageEnergyLevel, sim.getPopulation()[0].getSteps(), data.totalAlives});
+}
+
+void saveBestGenome(GenomeWriter& genomes, EvolutionSimulation& sim) {
+    // Сохранение весов лучшей нейросети
+    if (genomes.isOpen()) {
+        genomes.write(sim.getPopulation()[0].getGene(), sim.getGeneration(), sim.getSimulationData().averageEnergyLevel);
     }
-    // Сохранение конфигурации и весов лучшей нейросети
-    else if (typeSave == 'd') {
-        string data = sim.getPopulation()[0]->getGene().saveDataCSV();
-        file << data << "               " << sim.getGeneration() << "               " << sim.getSimulationData().averageEnergyLevel << "\n";
-        file.flush();
+}
+
+// Поколения прогрева буферов (поле, арены, пул геномов), не входящие в счет выделений
+static const int WARMUP_GENERATIONS = 50;
+
+// Выделения памяти внутри тиков после прогрева, в том числе тиков арен (только при сборке с COUNT_ALLOCATIONS)
+static uint64_t steadyTickAllocations = 0;
+static long long steadyTicks = 0;
+
+// Выделения памяти при смене поколений после прогрева
+static uint64_t steadyTurnoverAllocations = 0;
+static long long steadyTurnovers = 0;
+
+/**
+ * @brief Переход к следующему поколению: отбор, скрещивание, мутации и новое поле.
+ */
+void nextGeneration(EvolutionSimulation& sim) {
+    uint64_t allocationsBefore = getAllocationCount();
+    sim.geneticAlgorithm();
+    sim.reloadGrid();
+
+    if (sim.getGeneration() > WARMUP_GENERATIONS) {
+        steadyTurnoverAllocations += getAllocationCount() - allocationsBefore;
+        steadyTurnovers++;
     }
 }
 
-void runARound(EvolutionSimulation& sim, bool visualize) {
-    if (visualize) {
-        // Визуализация раунда/поколения
-        for (int step = 1; step <= NUMBER_OF_STEPS; step++) {
-            updateField(sim.getGrid(), sim, GENERATIONS, SKIP_GENERATIONS, step, NUMBER_OF_STEPS);
+void runARound(EvolutionSimulation& sim, bool visualize, ThreadPool* pool = nullptr, RoundRecorder* recorder = nullptr) {
+    if (visualize && !Headless) {
+        // Визуализация раунда/поколения: темп задает целевой интервал тика, а не время отрисовки
+        auto nextTick = chrono::steady_clock::now();
+        for (int step = 1; step <= NumberOfSteps; step++) {
+            updateField(sim.getGrid(), sim, Generations, SkipGenerations, step, NumberOfSteps);
+            sim.clearGridChanges();
 
             if (!sim.simulateStep()) { break; }
+            if (recorder) { recorder->recordTick(sim); }
 
-            this_thread::sleep_for(chrono::milliseconds(TICK_MS)); // FPS
+            nextTick = max(nextTick + chrono::milliseconds(TickMs), chrono::steady_clock::now());
+            this_thread::sleep_until(nextTick); // FPS
         }
+        return;
+    }
+
+    uint64_t allocationsBefore = getAllocationCount();
+    int ticks = 0;
+    if (pool) {
+        // Оценка в параллельных аренах (каждая арена тикает на своих буферах)
+        ticks = sim.evaluateInArenas(*pool, ArenaCount);
     } else {
-        for (int step = 1; step <= NUMBER_OF_STEPS; step++) {
+        for (int step = 1; step <= NumberOfSteps; step++) {
             if (!sim.simulateStep()) { break; }
+            if (recorder) { recorder->recordTick(sim); }
+            ticks++;
         }
-        updateField(sim.getGrid(), sim, GENERATIONS, SKIP_GENERATIONS, NUMBER_OF_STEPS, NUMBER_OF_STEPS);
     }
+
+    // После прогрева тики не должны выделять память (в аренах - вместе с раздачей задач пулу)
+    if (sim.getGeneration() > WARMUP_GENERATIONS) {
+        steadyTickAllocations += getAllocationCount() - allocationsBefore;
+        steadyTicks += ticks;
+    }
+
+    // Без терминала изменения поля никто не читает
+    if (!Headless) {
+        updateField(sim.getGrid(), sim, Generations, SkipGenerations, NumberOfSteps, NumberOfSteps);
+    }
+    sim.clearGridChanges();
 }
 
-void _train() {
-    std::ofstream statsFile("simulation_stats.csv", std::ios::app);
-    std::ofstream dataFile("simulation_data.csv", std::ios::app);
-    statsFile << "Generation;AvgEnergy;TopSteps;AliveAgents" << std::endl;
+/**
+ * @brief Готовит каталог записей раундов.
+ * @return Запись включена (задан record-dir и каталог создан).
+ */
+bool prepareRecordDir() {
+    if (RecordDir.empty()) {
+        return false;
+    }
 
-    auto field = createField(FIELD_WIDTH, FIELD_HEIGHT);
-    EvolutionSimulation sim(field);
+    error_code error;
+    filesystem::create_directories(RecordDir, error);
+    if (error) {
+        cerr << "Cannot create recording directory " << RecordDir << ", rounds will not be recorded\n";
+        return false;
+    }
+    return true;
+}
 
-    while (sim.getGeneration() < GENERATIONS) {
+/**
+ * @brief Раунд с визуализацией, при включенной записи раунд сохраняется в record-dir (см. recording.h).
+ * @param recorder nullptr - без записи.
+ */
+void runVisualRound(EvolutionSimulation& sim, RoundRecorder* recorder) {
+    if (!recorder) {
         runARound(sim, true);
+        return;
+    }
 
-        saveStatistic(statsFile, sim, 's');
-        sim.geneticAlgorithm();
-        sim.reloadGrid();
+    recorder->begin(sim, RecordKeyframeInterval);
+    runARound(sim, true, nullptr, recorder);
+
+    // Одно поколение может показываться несколько раз (и после продолжения обучения) - файлы не затираются
+    char name[32];
+    snprintf(name, sizeof(name), "gen_%06d", sim.getGeneration());
+    string base = (filesystem::path(RecordDir) / name).string();
+    string path = base + ".rec";
+    error_code error;
+    for (int copy = 2; filesystem::exists(path, error); copy++) {
+        path = base + "_" + to_string(copy) + ".rec";
+    }
+
+    if (!recorder->save(path)) {
+        cerr << "Cannot write recording: " << path << "\n";
+    }
+}
+
+Grid createTrainingField() {
+    // createField очищает экран и готовит буферы вывода, без терминала достаточно пустого поля
+    if (Headless) {
+        return Grid(FieldWidth, FieldHeight);
+    }
+
+    Grid field = createField(FieldWidth, FieldHeight);
+    if (UseRenderThread) {
+        startRenderThread(FrameMs);
+    }
+    return field;
+}
+
+void printTrainingSummary(int generations, chrono::steady_clock::time_point start) {
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << "Generations: " << generations << ", time: " << seconds << " s";
+    if (seconds > 0) {
+        cout << ", " << generations / seconds << " gen/s";
+    }
+    cout << ", seed: " << getGlobalSeed() << "\n";
+
+    if (allocationCountingEnabled() && steadyTicks > 0) {
+        cout << "Heap allocations in steady-state ticks: " << steadyTickAllocations << " over " << steadyTicks << " ticks\n";
+    }
+    if (allocationCountingEnabled() && steadyTurnovers > 0) {
+        cout << "Heap allocations in steady-state generation turnover: " << steadyTurnoverAllocations << " over " << steadyTurnovers << " generations\n";
+    }
+}
+
+void _train() {
+    GenomeWriter dataFile;
+    if (!dataFile.open(GenomeFile)) {
+        cerr << "Best genomes will not be saved\n";
+    }
+
+    // При продолжении популяция и еда берутся из контрольной точки
+    auto field = createTrainingField();
+    EvolutionSimulation sim(field, Resume ? 0 : InitPopSize, Resume ? 0 : InitFoodCount);
+
+    // Номер раунда в цикле обучения: 0 - раунд с визуализацией, дальше пропускаемые
+    int round = 0;
+    if (Resume && !sim.loadSimulationState(CheckpointFile, &round)) {
+        stopRenderThread();
+        cerr << "Cannot resume training from " << CheckpointFile << "\n";
+        return;
+    }
+
+    // При продолжении строки, записанные прерванным запуском после контрольной точки, отбрасываются
+    StatsSink stats;
+    if (!stats.open(StatsFile, false, StatsFlushMs, Resume ? sim.getGeneration() : -1)) {
+        cerr << "Statistics will not be saved\n";
+    }
+    auto start = chrono::steady_clock::now();
+
+    // Пул для параллельной оценки поколений
+    unique_ptr<ThreadPool> pool;
+    if (ArenaCount > 0) {
+        pool = make_unique<ThreadPool>(WorkerThreads);
+    }
+
+    // Раунды с визуализацией записываются, если задан каталог записей
+    RoundRecorder recorder;
+    RoundRecorder* recording = prepareRecordDir() ? &recorder : nullptr;
+
+    // Контрольные точки берутся на границе поколений вместе с номером следующего раунда цикла
+    CheckpointWriter checkpoints(CheckpointFile, CheckpointInBackground);
+    int lastCheckpoint = sim.getGeneration();
+    auto checkpoint = [&](int nextRound) {
+        if (CheckpointInterval > 0 && sim.getGeneration() - lastCheckpoint >= CheckpointInterval) {
+            checkpoints.save(sim, nextRound);
+            lastCheckpoint = sim.getGeneration();
+        }
+    };
+
+    while (sim.getGeneration() < Generations) {
+        if (round == 0) {
+            runVisualRound(sim, recording);
+
+            saveStatistic(stats, sim);
+            nextGeneration(sim);
+            round = 1;
+            checkpoint(round);
+        }
         
         // Пропуск раундов/поколений без визуализации
-        for (int gen_skip = 1; gen_skip <= SKIP_GENERATIONS - 1; gen_skip++) {
-            runARound(sim, false);
+        for (; round <= SkipGenerations - 1 && sim.getGeneration() < Generations; round++) {
+            runARound(sim, false, pool.get());
 
-            saveStatistic(statsFile, sim, 's');
+            saveStatistic(stats, sim);
 
             // Проверяем удачные ли гены
             sim.sortPop();
-            if (sim.getSimulationData().averageEnergyLevel >= INIT_ENERGY_AGENT * 2.0f) {
-                saveStatistic(dataFile, sim, 'd');
+            if (sim.getSimulationData().averageEnergyLevel >= InitEnergyAgent * 2.0f) {
+                saveBestGenome(dataFile, sim);
 
-                sim.geneticAlgorithm();
-                sim.reloadGrid();
+                nextGeneration(sim);
 
-                runARound(sim, true);
+                runVisualRound(sim, recording);
             } else {
-                sim.geneticAlgorithm();
-                sim.reloadGrid();
+                nextGeneration(sim);
             }
+            checkpoint(round + 1);
         }
+        if (round > SkipGenerations - 1) {
+            round = 0;
+        }
+    }
+
+    // Последняя точка позволяет продолжить обучение с большим generations
+    if (CheckpointInterval > 0 && sim.getGeneration() != lastCheckpoint) {
+        checkpoints.save(sim, round);
     }
-    updateField(sim.getGrid(), sim, GENERATIONS, SKIP_GENERATIONS, NUMBER_OF_STEPS, NUMBER_OF_STEPS);
+    checkpoints.flush();
+
+    if (!Headless) {
+        updateField(sim.getGrid(), sim, Generations, SkipGenerations, NumberOfSteps, NumberOfSteps);
+        stopRenderThread(); // Итоговый кадр рисуется до сводки
+    }
+    printTrainingSummary(sim.getGeneration(), start);
     
-    statsFile.close();
-    dataFile.close();
+    stats.close();
+}
+
+void _trainIslands() {
+    StatsSink stats;
+    if (!stats.open(StatsFile, true, StatsFlushMs)) {
+        cerr << "Statistics will not be saved\n";
+    }
+    GenomeWriter dataFile;
+    if (!dataFile.open(GenomeFile)) {
+        cerr << "Best genomes will not be saved\n";
+    }
+
+    if (Resume || CheckpointInterval > 0) {
+        cerr << "Checkpoints are not supported by the island model, training starts from scratch\n";
+    }
+    if (!RecordDir.empty()) {
+        cerr << "The island model has no visualized rounds, nothing will be recorded\n";
+    }
+
+    Grid field(FieldWidth, FieldHeight); // Острова не визуализируются
+
+    IslandSettings settings;
+    settings.islandCount = IslandCount;
+    settings.migrationInterval = MigrationInterval;
+    settings.migrantCount = MigrantCount;
+    settings.topology = MigrationTopologyMode == 1 ? FULLY_CONNECTED : RING;
+
+    IslandModel model(field, settings);
+    std::mutex filesLock; // Острова пишут в общие файлы из своих потоков
+    auto start = chrono::steady_clock::now();
+
+    model.run(Generations, [&](int island, EvolutionSimulation& sim) {
+        std::lock_guard<std::mutex> guard(filesLock);
+
+        saveStatistic(stats, sim, island);
+
+        // Сохраняем удачные гены
+        if (sim.getSimulationData().averageEnergyLevel >= InitEnergyAgent * 2.0f) {
+            saveBestGenome(dataFile, sim);
+        }
+    });
+
+    for (int i = 0; i < model.getIslandCount(); i++) {
+        const auto data = model.getIsland(i).getSimulationData();
+        cout << "Island " << i << ": generation " << data.generation << ", mutation power " << data.mutationPower << "\n";
+    }
+    printTrainingSummary(Generations * model.getIslandCount(), start);
+
+    stats.close();
 }
 
 void _show(ProgramParameters param) {
-    param = parseFile(param);
+    unique_ptr<NeuralNetwork> network = loadTrainedNetwork(GenomeFile);
+    if (!network) {
+        return;
+    }
+
+    // Размеры сети берутся из архива
+    const auto& layers = network->getLayers();
+    param.useNeuralNetwork = true;
+    param.InputValues = layers.front()->getInputSize();
+    param.NeuronsInHiddenLayer = layers.front()->getOutputSize();
+    param.OutputValues = layers.back()->getOutputSize();
     settingConstants(param);
     
-    auto field = createField(FIELD_WIDTH, FIELD_HEIGHT);
-    EvolutionSimulation sim(move(field), 0, 0);
-    sim.tuneSimWithTrainedAgents(field, param);
+    auto field = createField(FieldWidth, FieldHeight);
+    if (UseRenderThread) {
+        startRenderThread(FrameMs);
+    }
+    EvolutionSimulation sim(field, 0, 0);
+    sim.tuneSimWithTrainedAgents(field, *network);
     sim.reloadGrid();
+
+    RoundRecorder recorder;
+    RoundRecorder* recording = prepareRecordDir() ? &recorder : nullptr;
     
     while (true) {
-        runARound(sim, true);
+        runVisualRound(sim, recording);
         sim.reloadGrid();
     }
 }
 
+/**
+ * @brief Проигрывает запись раунда с replay-from по replay-to (назад, если replay-to меньше).
+ *
+ * Нужны только типы клеток и статистика из записи, симуляция и нейросети не создаются.
+ * Без терминала кадры печатаются текстом подряд.
+ * @return false если запись не открылась или повреждена.
+ */
+bool _replay() {
+    RecordingPlayer player;
+    if (!player.open(ReplayFile)) {
+        return false;
+    }
+
+    int last = player.getFrameCount() - 1;
+    int from = min(ReplayFrom, last);
+    int to = ReplayTo < 0 ? last : min(ReplayTo, last);
+    int direction = from <= to ? 1 : -1;
+
+    if (Headless) {
+        for (int frame = from; ; frame += direction) {
+            if (!player.seek(frame)) {
+                cerr << "Recording is corrupted: " << ReplayFile << "\n";
+                return false;
+            }
+
+            const auto data = player.getSimulationData();
+            cout << "Frame " << frame << "/" << last << ", gen " << data.generation << ", food " << data.totalFood
+                 << ", agents " << data.populationSize - data.totalDeaths << "/" << data.populationSize
+                 << ", energy " << data.averageEnergyLevel << " (" << data.minEnergyLevel << ".." << data.maxEnergyLevel << ")\n";
+            printField(cout, player.getGrid());
+            cout << "\n";
+
+            if (frame == to) {
+                return true;
+            }
+        }
+    }
+
+    const Grid& grid = player.getGrid();
+    createField(grid.getWidth() - 2, grid.getHeight() - 2);
+    if (UseRenderThread) {
+        startRenderThread(FrameMs);
+    }
+
+    // Темп как у раунда с визуализацией, ускоренный в replay-speed раз
+    auto interval = chrono::duration<double, milli>(ReplaySpeed > 0 ? TickMs / ReplaySpeed : 0);
+    auto nextFrame = chrono::steady_clock::now();
+    bool ok = true;
+    for (int frame = from; ; frame += direction) {
+        if (!player.seek(frame)) {
+            ok = false;
+            break;
+        }
+        updateField(grid, player.getSimulationData(), player.getGeneration(), 0, frame, last);
+        player.clearGridChanges();
+
+        if (frame == to) {
+            break;
+        }
+        nextFrame = max(nextFrame + chrono::duration_cast<chrono::steady_clock::duration>(interval), chrono::steady_clock::now());
+        this_thread::sleep_until(nextFrame);
+    }
+    stopRenderThread();
+
+    if (!ok) {
+        cerr << "Recording is corrupted: " << ReplayFile << "\n";
+    }
+    return ok;
+}
+
 int main(int argc, char* argv[]) {
     ProgramParameters param;
 
-    if (argc == 1) {
-        param.type = 't';
+    if (!parseArguments(argc, argv, param.type)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    setGlobalSeed(RandomSeed);
+
+    if (!ConvertCsvFile.empty()) {
+        int converted = convertCsvToGenomes(ConvertCsvFile, GenomeFile);
+        if (converted < 0) {
+            return 1;
+        }
+        cout << "Converted " << converted << " genomes from " << ConvertCsvFile << " to " << GenomeFile << "\n";
+        return 0;
+    }
+
+    if (!ExportStatsFile.empty()) {
+        int exported = exportStatsToCsv(StatsFile, ExportStatsFile);
+        if (exported < 0) {
+            return 1;
+        }
+        cout << "Exported " << exported << " statistics rows from " << StatsFile << " to " << ExportStatsFile << "\n";
+        return 0;
+    }
+
+    if (!ReplayFile.empty()) {
+        return _replay() ? 0 : 1;
+    }
+
+    if (param.type == 't') {
         param.useNeuralNetwork = USE_A_NEURAL_NETWORK;
-        param.InputValues = INPUT_VALUES;
-        param.NeuronsInHiddenLayer = NEURONS_IN_HIDDEN_LAYER;
-        param.OutputValues = OUTPUT_VALUES;
-        param.activationMid = "relu";
-        param.activationLast = "sigmoid";
+        param.InputValues = InputValues;
+        param.NeuronsInHiddenLayer = NeuronsInHiddenLayer;
+        param.OutputValues = OutputValues;
         settingConstants(param);
-        _train();
-    } else if (argc == 2 && std::string(argv[1]) == "-v") {
-        param.type = 'v';
-        param.activationMid = "relu";
-        param.activationLast = "sigmoid";
+        if (IslandCount > 0) {
+            _trainIslands();
+        } else {
+            _train();
+        }
+    } else if (param.type == 'v') {
+        Headless = false; // Просмотр имеет смысл только в терминале
         _show(param);
     }
     
     return 0;
-}
\ No newline at end of file
+}
@@ -3,14 +3,14 @@
 #include <algorithm>
 #include <cmath>
 #include <sstream>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#endif
 #include "neural_network.h"
 #include "main.h"
 
 using namespace std;
 
-// Вспомогательная функция для генерации случайных чисел
-static mt19937 rng(random_device{}());
-
 float sigmoid(float x) {
     return 1.0f / (1.0f + exp(-x)); // F(x) = 1 / (1 + e^(-x * 3)), "плющим" значение до диапозона от 0 до 1
 }
@@ -22,65 +22,209 @@ float relu(float x) {
     // return x;
 }
 
-GeneLayer::GeneLayer(int inputSize, int outputSize, const string& activation) : activation(activation) {
-    weights.resize(inputSize, vector<float>(outputSize));
-    biases.resize(outputSize, 0.0f);
-    
-    uniform_real_distribution<float> dist(-1.0f, 1.0f);
-    
-    // Инициализация случайными весами
-    for (int i = 0; i < inputSize; i++) {
-        for (int j = 0; j < outputSize; j++) {
-            weights[i][j] = dist(rng);
-            // weights[i][j] = 0.5f;
+Activation parseActivation(const string& name) {
+    if (name == "sigmoid") {
+        return ACTIVATION_SIGMOID;
+    } else if (name == "relu") {
+        return ACTIVATION_RELU;
+    }
+    return ACTIVATION_NONE;
+}
+
+string activationName(Activation activation) {
+    switch (activation) {
+        case ACTIVATION_SIGMOID: return "sigmoid";
+        case ACTIVATION_RELU: return "relu";
+        default: return "none";
+    }
+}
+
+// Ядра полносвязного слоя: считают W * inputs + biases, активация применяется отдельно
+
+static void denseScalar(const float* weights, int stride, const float* biases, const float* inputs, int inputSize, float* outputs, int outputSize) {
+    for (int o = 0; o < outputSize; o++) {
+        const float* row = weights + o * stride;
+        float sum = 0.0f;
+        for (int i = 0; i < inputSize; i++) {
+            sum += inputs[i] * row[i];
+        }
+        outputs[o] = sum + biases[o];
+    }
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define DENSE_X86_KERNELS
+
+__attribute__((target("sse2")))
+static float horizontalSum(__m128 sum) {
+    __m128 high = _mm_movehl_ps(sum, sum);
+    sum = _mm_add_ps(sum, high);
+    high = _mm_shuffle_ps(sum, sum, 1);
+    return _mm_cvtss_f32(_mm_add_ss(sum, high));
+}
+
+__attribute__((target("sse2")))
+static void denseSSE(const float* weights, int stride, const float* biases, const float* inputs, int inputSize, float* outputs, int outputSize) {
+    for (int o = 0; o < outputSize; o++) {
+        const float* row = weights + o * stride; // Строки выровнены по 32 байта
+        __m128 acc = _mm_setzero_ps();
+        int i = 0;
+        for (; i + 4 <= inputSize; i += 4) {
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(inputs + i), _mm_load_ps(row + i)));
+        }
+
+        float sum = horizontalSum(acc);
+        for (; i < inputSize; i++) {
+            sum += inputs[i] * row[i];
         }
+        outputs[o] = sum + biases[o];
+    }
+}
+
+__attribute__((target("avx2")))
+static void denseAVX2(const float* weights, int stride, const float* biases, const float* inputs, int inputSize, float* outputs, int outputSize) {
+    for (int o = 0; o < outputSize; o++) {
+        const float* row = weights + o * stride;
+        __m256 acc = _mm256_setzero_ps();
+        int i = 0;
+        for (; i + 8 <= inputSize; i += 8) {
+            acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(inputs + i), _mm256_load_ps(row + i)));
+        }
+
+        __m128 acc4 = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+        if (i + 4 <= inputSize) {
+            acc4 = _mm_add_ps(acc4, _mm_mul_ps(_mm_loadu_ps(inputs + i), _mm_load_ps(row + i)));
+            i += 4;
+        }
+
+        float sum = horizontalSum(acc4);
+        for (; i < inputSize; i++) {
+            sum += inputs[i] * row[i];
+        }
+        outputs[o] = sum + biases[o];
+    }
+}
+#endif
+
+using DenseKernel = void (*)(const float*, int, const float*, const float*, int, float*, int);
+
+static DenseKernel selectDenseKernel() {
+#ifdef DENSE_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return denseAVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return denseSSE;
+    }
+#endif
+    return denseScalar;
+}
+
+void denseForward(const float* weights, int stride, const float* biases, const float* inputs, int inputSize, float* outputs, int outputSize, Activation activation) {
+    static const DenseKernel kernel = selectDenseKernel(); // Выбор один раз за запуск
+
+    kernel(weights, stride, biases, inputs, inputSize, outputs, outputSize);
+
+    // Функция активации выбрана заранее, в цикле по нейронам нет сравнений строк
+    switch (activation) {
+        case ACTIVATION_SIGMOID:
+            for (int o = 0; o < outputSize; o++) {
+                outputs[o] = sigmoid(outputs[o]);
+            }
+            break;
+        case ACTIVATION_RELU:
+            for (int o = 0; o < outputSize; o++) {
+                outputs[o] = relu(outputs[o]);
+            }
+            break;
+        case ACTIVATION_NONE:
+            break;
+    }
+}
+
+void crossUniform(float* first, float* second, int count, Random& rng) {
+    for (int start = 0; start < count; start += 32) {
+        uint32_t mask = rng();
+        int end = min(count, start + 32);
+        for (int k = start; k < end; k++, mask >>= 1) {
+            float a = first[k], b = second[k];
+            bool swapped = mask & 1;
+            first[k] = swapped ? b : a;
+            second[k] = swapped ? a : b;
+        }
+    }
+}
+
+void addUniformNoise(float* values, int count, float amplitude, Random& rng) {
+    float noise[64];
+    for (int start = 0; start < count; start += 64) {
+        int chunk = min(64, count - start);
+        rng.fillUniform(noise, chunk, -amplitude, amplitude);
+        for (int k = 0; k < chunk; k++) {
+            values[start + k] += noise[k];
+        }
+    }
+}
+
+GeneLayer::GeneLayer(int inputSize, int outputSize, const string& activation)
+    : inputSize(inputSize), outputSize(outputSize), stride(paddedStride(inputSize)),
+      parameters(GenomeBlock<Parameters>::allocate()), activation(parseActivation(activation)) {
+    Parameters& own = writable();
+    own.weights.assign((size_t)outputSize * stride, 0.0f);
+    own.biases.assign(outputSize, 0.0f);
+}
+
+GeneLayer::GeneLayer(int inputSize, int outputSize, const string& activation, Random& rng) : GeneLayer(inputSize, outputSize, activation) {
+    AlignedFloats& weights = writable().weights;
+    vector<float>& biases = writable().biases;
+
+    // Инициализация случайными весами (хвосты строк остаются нулевыми)
+    for (int o = 0; o < outputSize; o++) {
+        rng.fillUniform(&weights[o * stride], inputSize, -1.0f, 1.0f);
+        // weights[i][j] = 0.5f;
     }
     
     // Инициализация biases
-    for (int j = 0; j < outputSize; j++) {
-        biases[j] = dist(rng) * 0.3f;
+    for (auto& bias : biases) {
+        bias = rng.uniform(-1.0f, 1.0f) * 0.3f;
         // biases[j] = 0.5f * 0.1f;
     }
 }
 
+GeneLayer::GeneLayer(const LayerView& layer) : GeneLayer(layer.inputSize, layer.outputSize, activationName(layer.activation)) {
+    Parameters& own = writable();
+    for (int o = 0; o < outputSize; o++) {
+        copy(layer.weights + (size_t)o * layer.stride, layer.weights + (size_t)o * layer.stride + inputSize, &own.weights[o * stride]);
+    }
+    copy(layer.biases, layer.biases + outputSize, own.biases.begin());
+}
+
 vector<float> GeneLayer::forward(const vector<float>& inputs) const {
-    int outputSize = weights[0].size();
-    vector<float> outputs(outputSize, 0.0);
-    
-    // Матричное умножение
-    for (int j = 0; j < outputSize; j++) {
-        for (int i = 0; i < inputs.size(); i++) {
-            outputs[j] += inputs[i] * weights[i][j];
-        }
-        
-        // Смещение
-        outputs[j] += biases[j];
-        
-        // Функции активации
-        if (activation == "sigmoid") {
-            outputs[j] = sigmoid(outputs[j]);
-        } else if (activation == "relu") {
-            outputs[j] = relu(outputs[j]);
+    vector<float> outputs(outputSize);
+    forward(inputs.data(), outputs.data());
+    return outputs;
+}
+
+void GeneLayer::setWeights(const vector<vector<float>>& newWeights) {
+    AlignedFloats& weights = writable().weights;
+    for (int i = 0; i < inputSize && i < (int)newWeights.size(); i++) {
+        for (int o = 0; o < outputSize && o < (int)newWeights[i].size(); o++) {
+            weights[o * stride + i] = newWeights[i][o];
         }
     }
-    
-    return outputs;
 }
 
-void GeneLayer::mutate(float mutationPower) {
-    uniform_real_distribution<float> dist(-mutationPower, mutationPower);
+void GeneLayer::mutate(float mutationPower, Random& rng) {
+    Parameters& own = writable();
     
-    // Мутируем веса
-    for (auto& row : weights) {
-        for (auto& weight : row) {
-            weight += dist(rng);
-        }
+    // Мутируем веса построчно (хвосты строк остаются нулевыми)
+    for (int o = 0; o < outputSize; o++) {
+        addUniformNoise(&own.weights[o * stride], inputSize, mutationPower, rng);
     }
     
     // Мутируем смещения
-    for (auto& bias : biases) {
-        bias += dist(rng) * 0.5f;
-    }
+    addUniformNoise(own.biases.data(), outputSize, mutationPower * 0.5f, rng);
 }
 
 void NeuralNetwork::addLayer(unique_ptr<GeneLayer> layer) {
@@ -88,41 +232,78 @@ void NeuralNetwork::addLayer(unique_ptr<GeneLayer> layer) {
 }
 
 vector<float> NeuralNetwork::predict(const vector<float>& inputs) const {
-    vector<float> outputs = inputs;
-    
+    vector<float> outputs(layers.empty() ? inputs.size() : layers.back()->getOutputSize());
+    predict(inputs.data(), outputs.data());
+    return outputs;
+}
+
+void NeuralNetwork::predict(const float* inputs, float* outputs) const {
+    if (layers.empty()) {
+        return;
+    }
+
+    int width = 0;
     for (const auto& layer : layers) {
-        outputs = layer->forward(outputs);
+        width = max(width, layer->getOutputSize());
+    }
+
+    // Промежуточные активации - на стеке, для широких сетей - в куче
+    const int LOCAL_WIDTH = 64;
+    float local[2][LOCAL_WIDTH];
+    vector<float> wide;
+    float* buffers[2] = {local[0], local[1]};
+    if (width > LOCAL_WIDTH) {
+        wide.resize(width * 2);
+        buffers[0] = wide.data();
+        buffers[1] = wide.data() + width;
+    }
+
+    const float* current = inputs;
+    for (int l = 0; l < (int)layers.size(); l++) {
+        float* target = l + 1 == (int)layers.size() ? outputs : buffers[l % 2];
+        layers[l]->forward(current, target);
+        current = target;
     }
-    
-    return outputs;
 }
 
 unique_ptr<NeuralNetwork> NeuralNetwork::clone() const {
     auto newNet = make_unique<NeuralNetwork>();
     
-    // Копируем послойно
+    // Копируем послойно: слои разделяют веса с оригиналом до первого изменения
     for (const auto& layer : layers) {
-        const auto& weights = layer->getWeights();
-        const auto& biases = layer->getBiases();
-        string activation = layer->getActivation();
-        
-        auto newLayer = make_unique<GeneLayer>(weights.size(), weights[0].size(), activation);
-        
-        newLayer->setWeights(weights);
-        newLayer->setBiases(biases);
-        newNet->addLayer(move(newLayer));
+        newNet->addLayer(make_unique<GeneLayer>(*layer));
     }
     
     return newNet;
 }
 
-void NeuralNetwork::mutate(float mutationPower) {
+bool NeuralNetwork::assign(const NeuralNetwork& otherNet) {
+    const auto& otherLayers = otherNet.getLayers();
+    if (layers.size() != otherLayers.size()) {
+        return false;
+    }
+
+    for (size_t i = 0; i < layers.size(); i++) {
+        const GeneLayer& layer = *layers[i];
+        const GeneLayer& other = *otherLayers[i];
+        if (layer.getInputSize() != other.getInputSize() || layer.getOutputSize() != other.getOutputSize()) {
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < layers.size(); i++) {
+        *layers[i] = *otherLayers[i];
+    }
+    return true;
+}
+
+void NeuralNetwork::mutate(float mutationPower, Random& rng) {
     for (auto& layer : layers) {
-        layer->mutate(mutationPower);
+        layer->mutate(mutationPower, rng);
     }
 }
 
-void NeuralNetwork::crossing(NeuralNetwork& otherNet) {
+void NeuralNetwork::crossing(NeuralNetwork& otherNet, Random& rng) {
     auto& otherLayers = otherNet.getLayers();
     
     // Проверка совместимости
@@ -130,58 +311,33 @@ void NeuralNetwork::crossing(NeuralNetwork& otherNet) {
         return;
     }
     
-    uniform_real_distribution<float> dist(0.0, 1.0);
-
     for (int i = 0; i < layers.size(); i++) {
         auto& layer1 = layers[i];
         auto& layer2 = otherLayers[i];
         
-        auto weights1 = layer1->getWeightsCopy();
-        auto weights2 = layer2->getWeightsCopy();
-        auto biases1 = layer1->getBiasesCopy();
-        auto biases2 = layer2->getBiasesCopy();
-        
         // Проверка размеров
-        if (weights1.size() != weights2.size() || weights1[0].size() != weights2[0].size() || biases1.size() != biases2.size()) {
+        if (layer1->getInputSize() != layer2->getInputSize() || layer1->getOutputSize() != layer2->getOutputSize()) {
             continue;
         }
 
-        // Скрещивание весов
-        for (int i_val = 0; i_val < weights1.size(); i_val++) {
-            for (int j = 0; j < weights1[i_val].size(); j++) {
-                if (dist(rng) < 0.5f) {
-                    swap(weights1[i_val][j], weights2[i_val][j]);
-                }
-            }
-        }
-
-        // Скрещивание смещений
-        for (int i_val = 0; i_val < biases1.size(); i_val++) {
-            if (dist(rng) < 0.5f) {
-                swap(biases1[i_val], biases2[i_val]);
-            }
-        }
-        
-        // Устанавливаем новые значения
-        layer1->setWeights(weights1);
-        layer1->setBiases(biases1);
-        layer2->setWeights(weights2);
-        layer2->setBiases(biases2);
+        // Скрещивание весов и смещений прямо в буферах обоих слоев
+        crossUniform(layer1->getWeightData(), layer2->getWeightData(), layer1->getOutputSize() * layer1->getStride(), rng);
+        crossUniform(layer1->getBiases().data(), layer2->getBiases().data(), layer1->getOutputSize(), rng);
     }
 }
 
-NeuralGene::NeuralGene() {
+NeuralGene::NeuralGene(Random& rng) {
     neuralNet = make_unique<NeuralNetwork>();
 
-    neuralNet->addLayer(make_unique<GeneLayer>(InputValues, NeuronsInHiddenLayer, "relu"));
-    neuralNet->addLayer(make_unique<GeneLayer>(NeuronsInHiddenLayer, OutputValues, "sigmoid"));
+    neuralNet->addLayer(make_unique<GeneLayer>(InputValues, NeuronsInHiddenLayer, "relu", rng));
+    neuralNet->addLayer(make_unique<GeneLayer>(NeuronsInHiddenLayer, OutputValues, "sigmoid", rng));
 }
 
 NeuralGene::NeuralGene(unique_ptr<NeuralNetwork> network) : neuralNet(move(network)) {}
 
-pair<int, int> NeuralGene::decideDirection(const vector<Cell>& surroundings, int energy, pair<int, int> directionToFood) {
-    vector<float> inputs(InputValues);
-    
+void NeuralGene::encodeInputs(const Cell* surroundings, pair<int, int> directionToFood, int distanceToFood, float* inputs) {
+    fill(inputs, inputs + InputValues, 0.0f);
+
     // 4 клетки окружения
     for (int i = 0; i < 4; i++) {
         switch (surroundings[i].type) {
@@ -194,16 +350,20 @@ pair<int, int> NeuralGene::decideDirection(const vector<Cell>& surroundings, int
     
     inputs[4] = directionToFood.first;  // dx
     inputs[5] = directionToFood.second; // dy
+
+    // Близость еды (для сетей с 7 входами): 1 - еда рядом, 0 - еды нет
+    if (InputValues > 6) {
+        inputs[6] = distanceToFood < 0 ? 0.0f : 1.0f / (1.0f + distanceToFood);
+    }
     
     // Нормируем кол-во энергии
-    // inputs[6] = min((float)energy / (float)(INIT_ENERGY_AGENT * 2), 1.0f);
-    
-    vector<float> outputs = neuralNet->predict(inputs); // 0 - Вниз, 1 - Вверх, 2 - Влево, 3 - Вправо
-    
+    // inputs[6] = min((float)energy / (float)(InitEnergyAgent * 2), 1.0f);
+}
+
+pair<int, int> NeuralGene::directionFromOutputs(const float* outputs, int count) {
     // Находим направление с максимальным значением
     int index = -1;
-    auto el = max_element(outputs.begin(), outputs.end());
-    int max_i = distance(outputs.begin(), el);
+    int max_i = max_element(outputs, outputs + count) - outputs;
     if (outputs[max_i] > 0.5f) {
         index = max_i;
     }
@@ -218,44 +378,65 @@ pair<int, int> NeuralGene::decideDirection(const vector<Cell>& surroundings, int
     }
 }
 
+pair<int, int> NeuralGene::decideDirection(const Cell* surroundings, int energy, pair<int, int> directionToFood, int distanceToFood) {
+    const int LOCAL_SIZE = 64;
+    int outputCount = neuralNet->getLayers().back()->getOutputSize();
+    if (InputValues > LOCAL_SIZE || outputCount > LOCAL_SIZE) {
+        vector<float> inputs(InputValues);
+        encodeInputs(surroundings, directionToFood, distanceToFood, inputs.data());
+        vector<float> outputs = neuralNet->predict(inputs);
+        return directionFromOutputs(outputs.data(), outputs.size());
+    }
+
+    float inputs[LOCAL_SIZE];
+    float outputs[LOCAL_SIZE];
+    encodeInputs(surroundings, directionToFood, distanceToFood, inputs);
+    neuralNet->predict(inputs, outputs); // 0 - Вверх, 1 - Влево, 2 - Вправо, 3 - Вниз
+    
+    return directionFromOutputs(outputs, outputCount);
+}
+
 unique_ptr<Gene> NeuralGene::clone() const {
     auto newNeuralNet = neuralNet->clone();
     return make_unique<NeuralGene>(move(newNeuralNet)); // NeuralGene === Gene
 }
 
-unique_ptr<Gene> NeuralGene::mutation(float mutationPower) const {
-    auto mutatedNet = neuralNet->clone();
-    mutatedNet->mutate(mutationPower);
-    return make_unique<NeuralGene>(move(mutatedNet));
+bool NeuralGene::assign(const Gene& otherGene) {
+    const NeuralGene* otherNeuralGene = dynamic_cast<const NeuralGene*>(&otherGene);
+    return otherNeuralGene && neuralNet->assign(otherNeuralGene->getNeuralNet());
 }
 
-void NeuralGene::crossing(Gene& otherGene) {
+void NeuralGene::mutate(float mutationPower, Random& rng) {
+    neuralNet->mutate(mutationPower, rng);
+}
+
+void NeuralGene::crossing(Gene& otherGene, Random& rng) {
     NeuralGene* otherNeuralGene = dynamic_cast<NeuralGene*>(&otherGene);
     if (otherNeuralGene) {
-        neuralNet->crossing(otherNeuralGene->getNeuralNet());
+        neuralNet->crossing(otherNeuralGene->getNeuralNet(), rng);
     }
 }
 
 string NeuralGene::saveDataCSV() const {
-    const auto& weights1 = neuralNet->getLayers()[0]->getWeights();
-    const auto& weights2 = neuralNet->getLayers()[1]->getWeights();
-    const auto& biases1 = neuralNet->getLayers()[0]->getBiases();
-    const auto& biases2 = neuralNet->getLayers()[1]->getBiases();
+    const GeneLayer& layer1 = *neuralNet->getLayers()[0];
+    const GeneLayer& layer2 = *neuralNet->getLayers()[1];
+    const auto& biases1 = layer1.getBiases();
+    const auto& biases2 = layer2.getBiases();
     
     stringstream data;
     data << fixed;
     
     data << "InputValues;InHiddenLayer;OutputValues;ActivationMid;ActivationLast\n";
-    data << (int)weights1.size() << ";";
-    data << (int)weights2.size() << ";";
-    data << (int)weights2[0].size() << ";";
-    data << neuralNet->getLayers()[0]->getActivation() << ";";
-    data << neuralNet->getLayers()[1]->getActivation() << "\n";
-
-    // Сохраняем веса первого слоя
-    for (int i = 0; i < weights1.size(); i++) {
-        for (int j = 0; j < weights1[i].size(); j++) {
-            data << (float)weights1[i][j] << "\n";
+    data << layer1.getInputSize() << ";";
+    data << layer2.getInputSize() << ";";
+    data << layer2.getOutputSize() << ";";
+    data << layer1.getActivation() << ";";
+    data << layer2.getActivation() << "\n";
+
+    // Сохраняем веса первого слоя (в файле порядок [вход][выход])
+    for (int i = 0; i < layer1.getInputSize(); i++) {
+        for (int j = 0; j < layer1.getOutputSize(); j++) {
+            data << layer1.getWeight(i, j) << "\n";
         }
     }
     
@@ -265,9 +446,9 @@ string NeuralGene::saveDataCSV() const {
     }
     
     // Сохраняем веса второго слоя
-    for (int i = 0; i < weights2.size(); i++) {
-        for (int j = 0; j < weights2[i].size(); j++) {
-            data << (float)weights2[i][j] << "\n";
+    for (int i = 0; i < layer2.getInputSize(); i++) {
+        for (int j = 0; j < layer2.getOutputSize(); j++) {
+            data << layer2.getWeight(i, j) << "\n";
         }
     }
     
@@ -277,4 +458,4 @@ string NeuralGene::saveDataCSV() const {
     }
 
     return data.str();
-}
\ No newline at end of file
+}
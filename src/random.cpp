@@ -0,0 +1,138 @@
+#include <random>
+#include <utility>
+#include "random.h"
+
+using namespace std;
+
+static uint64_t globalSeed = 1;
+
+// Константы Philox4x32
+static const uint32_t PHILOX_M0 = 0xD2511F53;
+static const uint32_t PHILOX_M1 = 0xCD9E8D57;
+static const uint32_t PHILOX_W0 = 0x9E3779B9;
+static const uint32_t PHILOX_W1 = 0xBB67AE85;
+
+static uint64_t splitmix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+Random::Random() : Random(0, 0) {}
+
+Random::Random(uint64_t seed, uint64_t stream) : counter{0, 0, 0, 0}, buffer{0, 0, 0, 0}, index(4) {
+    uint64_t k = splitmix64(seed ^ splitmix64(stream));
+    key[0] = (uint32_t)k;
+    key[1] = (uint32_t)(k >> 32);
+}
+
+void Random::refill() {
+    uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+    uint32_t k0 = key[0], k1 = key[1];
+
+    for (int round = 0; round < 10; round++) {
+        uint64_t p0 = (uint64_t)PHILOX_M0 * c0;
+        uint64_t p1 = (uint64_t)PHILOX_M1 * c2;
+
+        uint32_t n0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+        uint32_t n2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+        c1 = (uint32_t)p1;
+        c3 = (uint32_t)p0;
+        c0 = n0;
+        c2 = n2;
+
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+
+    buffer[0] = c0;
+    buffer[1] = c1;
+    buffer[2] = c2;
+    buffer[3] = c3;
+    index = 0;
+
+    discard(1);
+}
+
+int Random::uniformInt(int lo, int hi) {
+    uint32_t range = (uint32_t)(hi - lo) + 1;
+    if (range == 0) {
+        return lo + (int)(*this)(); // Весь диапазон uint32
+    }
+
+    // Метод Лемира: умножение вместо деления, отбрасывание смещенных значений
+    uint64_t m = (uint64_t)(*this)() * range;
+    uint32_t low = (uint32_t)m;
+    if (low < range) {
+        uint32_t threshold = -range % range;
+        while (low < threshold) {
+            m = (uint64_t)(*this)() * range;
+            low = (uint32_t)m;
+        }
+    }
+
+    return lo + (int)(m >> 32);
+}
+
+void Random::fillUniform(float* out, int count, float lo, float hi) {
+    float scale = (hi - lo) * (1.0f / 16777216.0f);
+    int i = 0;
+
+    // Сначала добираем остаток текущего блока, затем берем блоки целиком
+    while (i < count && index < 4) {
+        out[i++] = lo + (buffer[index++] >> 8) * scale;
+    }
+
+    while (i + 4 <= count) {
+        refill();
+        out[i] = lo + (buffer[0] >> 8) * scale;
+        out[i + 1] = lo + (buffer[1] >> 8) * scale;
+        out[i + 2] = lo + (buffer[2] >> 8) * scale;
+        out[i + 3] = lo + (buffer[3] >> 8) * scale;
+        index = 4;
+        i += 4;
+    }
+
+    while (i < count) {
+        out[i++] = uniform(lo, hi);
+    }
+}
+
+Random Random::split() {
+    uint64_t seed = next64();
+    uint64_t stream = next64();
+    return Random(seed, stream);
+}
+
+void Random::discard(uint64_t blocks) {
+    // 128-битное сложение счетчика
+    uint64_t low = ((uint64_t)counter[1] << 32) | counter[0];
+    uint64_t sum = low + blocks;
+    uint64_t carry = sum < low ? 1 : 0;
+    counter[0] = (uint32_t)sum;
+    counter[1] = (uint32_t)(sum >> 32);
+
+    if (carry) {
+        uint64_t high = (((uint64_t)counter[3] << 32) | counter[2]) + 1;
+        counter[2] = (uint32_t)high;
+        counter[3] = (uint32_t)(high >> 32);
+    }
+}
+
+uint64_t mixStream(uint64_t a, uint64_t b) {
+    return splitmix64(a ^ splitmix64(b + 0x632BE59BD9B4E019ull));
+}
+
+uint64_t setGlobalSeed(uint64_t seed) {
+    if (seed == 0) {
+        random_device device;
+        seed = ((uint64_t)device() << 32) | device();
+    }
+    globalSeed = seed;
+    return globalSeed;
+}
+
+uint64_t getGlobalSeed() {
+    return globalSeed;
+}
@@ -0,0 +1,355 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include "recording.h"
+#include "genome_file.h"
+
+using namespace std;
+
+static const char FILE_MAGIC[4] = {'A', 'G', 'R', 'C'};
+static const uint32_t FORMAT_VERSION = 1;
+
+struct RecordingHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t fileSize;
+    uint64_t checksum;         // FNV-1a всех байтов после заголовка
+    int32_t width;
+    int32_t height;
+    int32_t generation;
+    int32_t populationSize;
+    float mutationPower;
+    uint32_t frameCount;
+    uint32_t keyframeInterval;
+    uint32_t keyframeCount;
+    uint64_t streamOffset;
+};
+
+static_assert(sizeof(RecordingHeader) == 64, "recording header must be 64 bytes");
+
+/**
+ * @brief Раскладывает статистику симуляции в поля кадра (порядок - см. recording.h).
+ */
+static void collectStats(const EvolutionSimulation::SimulationData& data, int32_t* stats) {
+    stats[0] = data.totalFood;
+    stats[1] = data.averageEnergyLevel;
+    stats[2] = data.maxEnergyLevel;
+    stats[3] = data.minEnergyLevel;
+    stats[4] = data.totalAlives;
+    stats[5] = data.totalDeaths;
+}
+
+static void putVarint(vector<unsigned char>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back((unsigned char)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((unsigned char)value);
+}
+
+/**
+ * @brief Читает varint и сдвигает указатель.
+ * @return false если число обрывается концом буфера или длиннее 64 бит.
+ */
+static bool getVarint(const unsigned char*& in, const unsigned char* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && in < end; shift += 7) {
+        unsigned char byte = *in++;
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Приращения статистики бывают отрицательными: zigzag делает малые по модулю числа короткими
+static uint64_t zigzag(int64_t value) { return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63); }
+static int64_t unzigzag(uint64_t value) { return (int64_t)(value >> 1) ^ -(int64_t)(value & 1); }
+
+RoundRecorder::RoundRecorder()
+    : width(0), height(0), generation(0), populationSize(0), mutationPower(0),
+      keyframeInterval(1), frameCount(0), shownStats{} {}
+
+void RoundRecorder::begin(const EvolutionSimulation& sim, int newKeyframeInterval) {
+    const Grid& grid = sim.getGrid();
+    const auto data = sim.getSimulationData();
+
+    width = grid.getWidth();
+    height = grid.getHeight();
+    generation = data.generation;
+    populationSize = data.populationSize;
+    mutationPower = data.mutationPower;
+    keyframeInterval = max(newKeyframeInterval, 1);
+
+    shown = grid.getTypes();
+    collectStats(data, shownStats);
+
+    index.clear();
+    keyframes.clear();
+    stream.clear();
+
+    frameCount = 1;
+    addKeyframe();
+}
+
+void RoundRecorder::addKeyframe() {
+    RecordingKeyframe entry{};
+    entry.frame = frameCount - 1;
+    entry.offset = keyframes.size();
+    entry.streamOffset = stream.size();
+    index.push_back(entry);
+
+    size_t offset = keyframes.size();
+    keyframes.resize(offset + sizeof(shownStats) + (shown.size() + 3) / 4, 0);
+    memcpy(&keyframes[offset], shownStats, sizeof(shownStats));
+
+    unsigned char* packed = &keyframes[offset + sizeof(shownStats)];
+    for (size_t i = 0; i < shown.size(); i++) {
+        packed[i / 4] |= shown[i] << (i % 4 * 2);
+    }
+}
+
+void RoundRecorder::recordTick(const EvolutionSimulation& sim) {
+    const Grid& grid = sim.getGrid();
+
+    // Клетка могла смениться и вернуться к прежнему типу за тик - такие не записываются
+    changed.clear();
+    for (int i : grid.getDirtyCells()) {
+        if (grid.getType(i) != shown[i]) {
+            changed.push_back(i);
+        }
+    }
+    sort(changed.begin(), changed.end());
+
+    putVarint(stream, changed.size());
+    int previous = -1;
+    for (int i : changed) {
+        uint8_t type = grid.getType(i);
+        putVarint(stream, (uint64_t)(i - previous - 1) << 4 | shown[i] << 2 | type);
+        shown[i] = type;
+        previous = i;
+    }
+
+    int32_t now[RECORDED_STATS];
+    collectStats(sim.getSimulationData(), now);
+    for (int k = 0; k < RECORDED_STATS; k++) {
+        putVarint(stream, zigzag((int64_t)now[k] - shownStats[k]));
+        shownStats[k] = now[k];
+    }
+
+    frameCount++;
+    if ((frameCount - 1) % keyframeInterval == 0) {
+        addKeyframe();
+    }
+}
+
+bool RoundRecorder::save(const string& path) {
+    size_t keyframesOffset = sizeof(RecordingHeader) + index.size() * sizeof(RecordingKeyframe);
+    size_t streamOffset = keyframesOffset + keyframes.size();
+    output.resize(streamOffset + stream.size());
+
+    for (size_t k = 0; k < index.size(); k++) {
+        RecordingKeyframe entry = index[k];
+        entry.offset += keyframesOffset;
+        entry.streamOffset += streamOffset;
+        memcpy(&output[sizeof(RecordingHeader) + k * sizeof(entry)], &entry, sizeof(entry));
+    }
+    memcpy(&output[keyframesOffset], keyframes.data(), keyframes.size());
+    memcpy(&output[streamOffset], stream.data(), stream.size());
+
+    RecordingHeader header{};
+    memcpy(header.magic, FILE_MAGIC, 4);
+    header.version = FORMAT_VERSION;
+    header.fileSize = output.size();
+    header.checksum = fnv1a(output.data() + sizeof(header), output.size() - sizeof(header));
+    header.width = width;
+    header.height = height;
+    header.generation = generation;
+    header.populationSize = populationSize;
+    header.mutationPower = mutationPower;
+    header.frameCount = frameCount;
+    header.keyframeInterval = keyframeInterval;
+    header.keyframeCount = index.size();
+    header.streamOffset = streamOffset;
+    memcpy(output.data(), &header, sizeof(header));
+
+    // Запись - новый файл на каждый раунд, недописанный файл отсеивается контрольной суммой при чтении
+    ofstream file(path, ios::binary | ios::trunc);
+    file.write((const char*)output.data(), output.size());
+    file.close();
+    return !file.fail();
+}
+
+RecordingPlayer::RecordingPlayer()
+    : stats{}, generation(0), populationSize(0), mutationPower(0), frameCount(0), keyframeInterval(1), frame(-1) {}
+
+bool RecordingPlayer::open(const string& path) {
+    frame = -1;
+    if (!file.open(path, sizeof(RecordingHeader))) {
+        cerr << "Cannot open recording: " << path << "\n";
+        return false;
+    }
+
+    RecordingHeader header;
+    const unsigned char* data = file.getData();
+    size_t size = file.getSize();
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, FILE_MAGIC, 4) != 0 || header.version != FORMAT_VERSION) {
+        cerr << "Not a recording: " << path << "\n";
+        return false;
+    }
+
+    auto corrupted = [&]() {
+        cerr << "Recording is corrupted: " << path << "\n";
+        file.close();
+        return false;
+    };
+
+    if (header.fileSize != size || fnv1a(data + sizeof(header), size - sizeof(header)) != header.checksum) {
+        return corrupted();
+    }
+    if (header.width < 3 || header.height < 3 || header.width > 32768 || header.height > 32768
+        || header.frameCount == 0 || header.keyframeInterval == 0
+        || header.keyframeCount != (header.frameCount - 1) / header.keyframeInterval + 1
+        || header.keyframeCount > (size - sizeof(header)) / sizeof(RecordingKeyframe)
+        || header.streamOffset > size) {
+        return corrupted();
+    }
+
+    size_t cells = (size_t)header.width * header.height;
+    size_t keyframeBytes = sizeof(stats) + (cells + 3) / 4;
+    keyframes.resize(header.keyframeCount);
+    memcpy(keyframes.data(), data + sizeof(header), keyframes.size() * sizeof(RecordingKeyframe));
+
+    // Поток событий проверяется целиком, заодно запоминается начало события каждого кадра
+    eventOffsets.assign(header.frameCount, 0);
+    const unsigned char* in = data + header.streamOffset;
+    const unsigned char* end = data + size;
+    for (uint32_t f = 1; f < header.frameCount; f++) {
+        eventOffsets[f] = in - data;
+
+        uint64_t count, value;
+        if (!getVarint(in, end, count) || count > cells) {
+            return corrupted();
+        }
+        int64_t cell = -1;
+        for (uint64_t c = 0; c < count; c++) {
+            if (!getVarint(in, end, value) || (value >> 4) >= cells || (cell += (value >> 4) + 1) >= (int64_t)cells
+                || (value >> 2 & 3) == (value & 3)) {
+                return corrupted();
+            }
+        }
+        for (int k = 0; k < RECORDED_STATS; k++) {
+            if (!getVarint(in, end, value)) {
+                return corrupted();
+            }
+        }
+    }
+    if (in != end) {
+        return corrupted();
+    }
+
+    for (uint32_t k = 0; k < header.keyframeCount; k++) {
+        const RecordingKeyframe& keyframe = keyframes[k];
+        uint32_t next = keyframe.frame + 1;
+        size_t nextEvent = next < header.frameCount ? eventOffsets[next] : size;
+        if (keyframe.frame != k * header.keyframeInterval || keyframe.offset > size
+            || keyframeBytes > size - keyframe.offset || keyframe.streamOffset != nextEvent) {
+            return corrupted();
+        }
+    }
+
+    grid = Grid(header.width - 2, header.height - 2);
+    generation = header.generation;
+    populationSize = header.populationSize;
+    mutationPower = header.mutationPower;
+    frameCount = header.frameCount;
+    keyframeInterval = header.keyframeInterval;
+
+    return seek(0);
+}
+
+void RecordingPlayer::loadKeyframe(const RecordingKeyframe& keyframe) {
+    const unsigned char* bytes = file.getData() + keyframe.offset;
+    memcpy(stats, bytes, sizeof(stats));
+
+    const unsigned char* packed = bytes + sizeof(stats);
+    for (int i = 0; i < grid.getSize(); i++) {
+        grid.setType(i, (CellType)(packed[i / 4] >> (i % 4 * 2) & 3));
+    }
+    frame = keyframe.frame;
+}
+
+bool RecordingPlayer::applyEvents(int target, bool forward) {
+    const unsigned char* in = file.getData() + eventOffsets[target];
+    const unsigned char* end = file.getData() + file.getSize();
+
+    // Разметка потока проверена при открытии, здесь остается сверить события с полем
+    uint64_t count, value;
+    getVarint(in, end, count);
+    int cell = -1;
+    for (uint64_t c = 0; c < count; c++) {
+        getVarint(in, end, value);
+        cell += (int)(value >> 4) + 1;
+
+        CellType before = (CellType)(value >> 2 & 3);
+        CellType after = (CellType)(value & 3);
+        if (!forward) {
+            swap(before, after);
+        }
+        if (grid.getType(cell) != before) {
+            return false;
+        }
+        grid.setType(cell, after);
+    }
+
+    for (int k = 0; k < RECORDED_STATS; k++) {
+        getVarint(in, end, value);
+        int64_t delta = unzigzag(value);
+        stats[k] = (int32_t)(forward ? stats[k] + delta : stats[k] - delta);
+    }
+    return true;
+}
+
+bool RecordingPlayer::seek(int target) {
+    if (target < 0 || target >= frameCount) {
+        return false;
+    }
+
+    // От опорного кадра, если до него ближе, чем от текущего кадра
+    const RecordingKeyframe& keyframe = keyframes[target / keyframeInterval];
+    if (frame < 0 || target - (int)keyframe.frame < abs(target - frame)) {
+        loadKeyframe(keyframe);
+    }
+
+    for (; frame < target; frame++) {
+        if (!applyEvents(frame + 1, true)) {
+            frame = -1;
+            return false;
+        }
+    }
+    for (; frame > target; frame--) {
+        if (!applyEvents(frame, false)) {
+            frame = -1;
+            return false;
+        }
+    }
+    return true;
+}
+
+EvolutionSimulation::SimulationData RecordingPlayer::getSimulationData() const {
+    EvolutionSimulation::SimulationData data{};
+    data.populationSize = populationSize;
+    data.generation = generation;
+    data.mutationPower = mutationPower;
+    data.totalFood = stats[0];
+    data.averageEnergyLevel = stats[1];
+    data.maxEnergyLevel = stats[2];
+    data.minEnergyLevel = stats[3];
+    data.totalAlives = stats[4];
+    data.totalDeaths = stats[5];
+    return data;
+}
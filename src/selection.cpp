@@ -0,0 +1,56 @@
+#include <algorithm>
+#include "selection.h"
+#include "main.h"
+
+using namespace std;
+
+ParentSelection::ParentSelection() : settings{SELECTION_UNIFORM, 1, 1.0f, 1.0f}, fitness(nullptr), first(0), last(0) {}
+
+void ParentSelection::prepare(const SelectionSettings& newSettings, const vector<float>& newFitness, int newFirst, int newLast) {
+    settings = newSettings;
+    fitness = newFitness.data();
+    first = newFirst;
+    last = newLast;
+
+    if (settings.scheme == SELECTION_TRUNCATION) {
+        candidates.resize(last - first + 1);
+        for (int i = 0; i < (int)candidates.size(); i++) {
+            candidates[i] = first + i;
+        }
+
+        // Доля лучших отделяется за O(n), порядок внутри нее не важен
+        int count = clamp((int)(candidates.size() * settings.truncationShare), 1, (int)candidates.size());
+        nth_element(candidates.begin(), candidates.begin() + (count - 1), candidates.end(), [this](int a, int b) {
+            return fitness[a] > fitness[b] || (fitness[a] == fitness[b] && a < b);
+        });
+        candidates.resize(count);
+    }
+}
+
+int ParentSelection::select(Random& rng) const {
+    switch (settings.scheme) {
+        case SELECTION_TOURNAMENT: {
+            int winner = rng.uniformInt(first, last);
+            for (int k = 1; k < settings.tournamentSize; k++) {
+                winner = better(winner, rng.uniformInt(first, last));
+            }
+            return winner;
+        }
+        case SELECTION_RANK: {
+            // Лучший из двух с вероятностью pressure / 2 дает линейный ранговый отбор с тем же давлением
+            int a = rng.uniformInt(first, last);
+            int b = rng.uniformInt(first, last);
+            int winner = better(a, b);
+            return rng.uniform(0.0f, 1.0f) < settings.rankPressure * 0.5f ? winner : (winner == a ? b : a);
+        }
+        case SELECTION_TRUNCATION:
+            return candidates[rng.uniformInt(0, candidates.size() - 1)];
+        case SELECTION_UNIFORM:
+        default:
+            return rng.uniformInt(first, last);
+    }
+}
+
+SelectionSettings getSelectionSettings() {
+    return {(SelectionScheme)SelectionSchemeMode, TournamentSize, RankPressure, TruncationShare};
+}
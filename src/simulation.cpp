@@ -1,17 +1,19 @@
 #include <algorithm>
+#include <numeric>
 #include <random>
 #include <iostream>
+#include <climits>
 #include "simulation.h"
 #include "neural_network.h"
+#include "gene_factory.h"
 #include "main.h"
 
 using namespace std;
 
-// Вспомогательная функция для генерации случайных чисел
-static mt19937 rng(random_device{}());
-
-EvolutionSimulation::EvolutionSimulation(vector<vector<Cell>> grid, int initialPopulationSize, int initialFoodCount)
-    : grid(move(grid)), mutationPower(AGENT_MUTATION_POWER), generation(0), totalDeaths(0), totalAlives(INIT_POP_SIZE), currentTick(0)
+EvolutionSimulation::EvolutionSimulation(Grid grid, int initialPopulationSize, int initialFoodCount, uint64_t stream)
+    : grid(move(grid)), foodIndex(this->grid.getWidth(), this->grid.getHeight()), foodField(this->grid.getWidth(), this->grid.getHeight()), fitnessReady(false), mutationPower(AgentMutationPower), generation(0), totalDeaths(0), totalAlives(InitPopSize), currentTick(0),
+      energyTotal(0), energyMin(0), energyMax(0), energyAgents(0),
+      stream(stream), rng(getGlobalSeed(), stream), spawnChances(FoodAddTimes)
 {
     initializePopulation(initialPopulationSize);
     initializeFood(initialFoodCount);
@@ -25,6 +27,9 @@ EvolutionSimulation::~EvolutionSimulation()
 void EvolutionSimulation::initializePopulation(int initialPopulationSize)
 {
     population.clear(); // Удалим прошлую популяцию
+    population.reserve(initialPopulationSize);
+    vacatedCells.reserve(initialPopulationSize); // За тик клетку освобождает не больше одного раза каждый агент
+    recountEnergy();
     for (int i = 0; i < initialPopulationSize; i++) {
         int x, y;
         if (findRandomEmptyPosition(x, y)) {
@@ -35,9 +40,12 @@ void EvolutionSimulation::initializePopulation(int initialPopulationSize)
 
 
 void EvolutionSimulation::initializeFood(int initialFoodCount) {
-    uniform_int_distribution<int> random((int)ENERGY_FOOD_VALUE / 2, ENERGY_FOOD_VALUE);
+    // Используются первые initialFoodCount значений: повторные вызовы только продвигают генератор
     for (int i = 0; i < initialFoodCount; i++) {
-        FoodValue.push_back(random(rng));
+        int value = rng.uniformInt((int)EnergyFoodValue / 2, EnergyFoodValue);
+        if (i >= (int)FoodValue.size()) {
+            FoodValue.push_back(value);
+        }
     }
 
     for (int i = 0; i < initialFoodCount; i++) {
@@ -50,43 +58,34 @@ void EvolutionSimulation::initializeFood(int initialFoodCount) {
 
 bool EvolutionSimulation::findRandomEmptyPosition(int& x, int& y) const
 {
-    vector<pair<int, int>> emptyPos;
-    
-    // Собираем все пустые клетки
-    for (int x = 1; x < grid.size() - 1; x++) {
-        for (int y = 1; y < grid[x].size() - 1; y++) {
-            if (grid[x][y].type == EMPTY) {
-                emptyPos.emplace_back(x, y); /* Выбираем пары координат (x, y), тип клетки которых EMPTY */
-            }
-        }
-    }
+    int emptyCount = grid.getEmptyCount();
     
     // Свободно ли
-    if (emptyPos.empty()) {
+    if (emptyCount == 0) {
         return false;
     }
     
-    // Выбираем случайную позицию из массива пар (x, y)
-    uniform_int_distribution<int> dist(0, emptyPos.size() - 1); // Равномерное распределение от 0 до size - 1
-    auto [posX, posY] = emptyPos[dist(rng)]; // Выбираем случайный индекс emptyPos из {0, 1, ..., emptyPos.size() - 1} и берём его координаты
-    x = posX;
-    y = posY;
+    // Выбираем случайную клетку из поддерживаемого полем списка пустых клеток
+    int cell = grid.getEmptyCell(rng.uniformInt(0, emptyCount - 1)); // Равномерное распределение от 0 до size - 1
+    x = cell % grid.getWidth();
+    y = cell / grid.getWidth();
 
     return true;
 }
 
 bool EvolutionSimulation::simulateStep()
 {
+    fitnessReady = false;
     if (!updateAgents()) {
         return false;
     }
     
     currentTick++;
-    // Добавляем новую еду FOOD_ADD_TIMES раз каждые FOOD_SPAWN_INTERVAL тиков
-    if (currentTick % FOOD_SPAWN_INTERVAL == 0) {
-        uniform_int_distribution<int> random((int)(ENERGY_FOOD_VALUE / 3), (int)ENERGY_FOOD_VALUE);
-        for (int times = 0; times < FOOD_ADD_TIMES; times++) {
-            spawnNewFood(random);
+    // Добавляем новую еду FoodAddTimes раз каждые FoodSpawnInterval тиков
+    if (currentTick % FoodSpawnInterval == 0) {
+        rng.fillUniform(spawnChances.data(), FoodAddTimes, 0.0f, 1.0f);
+        for (int times = 0; times < FoodAddTimes; times++) {
+            spawnNewFood(spawnChances[times]);
         }
     }
     
@@ -98,121 +97,315 @@ bool EvolutionSimulation::simulateStep()
 bool EvolutionSimulation::updateAgents() {
     if (totalAlives == 0) { return false; }
 
-    // Перемешаем популяцию
-    shuffle(population.begin(), population.end(), rng);
-
-    for (auto& agent : population) {
-        if (agent->getIsAlive()) {
-            // Проверяем смерть от голода
-            if (agent->getEnergy() <= 0) {
-                agent->die();
-                totalDeaths++;
-                totalAlives--;
-
-                int x = agent->getX();
-                int y = agent->getY();
-                grid[x][y].type = EMPTY;
-                continue;
+    // Перемешаем порядок хода, сами агенты остаются на местах
+    order.resize(population.size());
+    iota(order.begin(), order.end(), 0);
+    rng.shuffle(order.begin(), order.end());
+
+    // Статистика энергии собирается по ходу обхода агентов
+    long long tickEnergy = 0;
+    int tickMin = INT_MAX, tickMax = INT_MIN, tickAgents = 0;
+
+    // Поле расстояний до еды общее на всех агентов тика, заново строится только после поедания
+    if (UseFoodField) {
+        foodField.build(grid);
+    }
+
+    // Сначала все осматриваются, затем сети всей популяции считаются одним пакетом
+    bool batched = UseNeuralNetwork && UseBatchInference && inference.prepare(population);
+    if (batched) {
+        for (int i : order) {
+            if (population.alive[i] && !checkStarvation(i)) {
+                senseAgent(i);
+            }
+        }
+        inference.decide(population, decisions);
+    }
+
+    for (int i : order) {
+        if (population.alive[i]) {
+            if (!batched) {
+                if (checkStarvation(i)) {
+                    continue;
+                }
+                senseAgent(i);
             }
 
-            // Агент осматривается
-            agent->lookAround(&grid);
-            agent->getDirectionToFood(&grid);
+            Agent agent = population[i];
             
             // Сохраняем старую позицию
-            int oldX = agent->getX();
-            int oldY = agent->getY();
+            int oldX = agent.getX();
+            int oldY = agent.getY();
             
             // Агент думает и делает свой ход
             // for (int i = 0; i < 16; i++) {
-            //     if (agent->decideAction(grid)) {
+            //     if (agent.decideAction(grid)) {
             //         break;
             //     }
             // }
-            agent->decideAction(grid);
+            if (batched) {
+                agent.act(decisions[i], grid);
+            } else {
+                agent.decideAction(grid);
+            }
             
             // Обновляем новую позицию
-            int newX = agent->getX();
-            int newY = agent->getY();
+            int newX = agent.getX();
+            int newY = agent.getY();
             
             // Если агент съел еду, обновляем клетку
-            if (grid[newX][newY].type == FOOD) {
-                grid[newX][newY].type = AGENT;
-                grid[newX][newY].foodValue = 0;
-                agent->stepTick();
+            // Старая клетка остается занятой до конца тика и освобождается в updateGrid()
+            if (grid.getType(newX, newY) == FOOD) {
+                grid.setType(newX, newY, AGENT);
+                grid.setFoodValue(newX, newY, 0);
+                foodIndex.remove(newX, newY);
+                foodField.invalidate();
+                vacatedCells.push_back(grid.index(oldX, oldY));
+                agent.stepTick();
             }
-            else if (grid[newX][newY].type == EMPTY) {
-                grid[newX][newY].type = AGENT;
-                agent->stepTick();
+            else if (grid.getType(newX, newY) == EMPTY) {
+                grid.setType(newX, newY, AGENT);
+                vacatedCells.push_back(grid.index(oldX, oldY));
+                agent.stepTick();
             } else {
                 // Если клетка занята, возвращаемся на старое место
-                agent->setX(oldX);
-                agent->setY(oldY);
-                grid[oldX][oldY].type = AGENT;
+                agent.setX(oldX);
+                agent.setY(oldY);
+                grid.setType(oldX, oldY, AGENT);
             }
+
+            int energy = agent.getEnergy();
+            tickEnergy += energy;
+            tickMin = min(tickMin, energy);
+            tickMax = max(tickMax, energy);
+            tickAgents++;
         }
     }
 
+    energyTotal = tickEnergy;
+    energyMin = tickAgents ? tickMin : 0;
+    energyMax = tickAgents ? tickMax : 0;
+    energyAgents = tickAgents;
+
     return true;
 }
 
-void EvolutionSimulation::sortPop() {
-    sort(population.begin(), population.end(),
-    [](const unique_ptr<Agent>& a, const unique_ptr<Agent>& b) { 
-        int A = (float)a->getSteps() * 0.2f + (float)a->getEnergy() * 0.8f;
-        int B = (float)b->getSteps() * 0.2f + (float)b->getEnergy() * 0.8f;
-        return A > B;
-    });
-    /*
-        return a->getEnergy() > b->getEnergy();
+bool EvolutionSimulation::checkStarvation(int i) {
+    if (population.energy[i] > 0) {
+        return false;
+    }
 
-        return a->getSteps() > b->getSteps();
+    population.alive[i] = 0;
+    totalDeaths++;
+    totalAlives--;
 
-        return a->getEnergy() > b->getEnergy();
-    */
+    grid.setType(population.x[i], population.y[i], EMPTY);
+    return true;
 }
 
-void EvolutionSimulation::geneticAlgorithm() {
-    vector<unique_ptr<Agent>> newPop;
-    uniform_real_distribution<float> random(0.0f, 1.0f);
-    uniform_int_distribution<int> randomAg(2, population.size() - 1);
+void EvolutionSimulation::senseAgent(int i) {
+    Agent agent = population[i];
+
+    agent.lookAround(grid);
+    if (UseFoodField) {
+        foodField.update(grid);
+        agent.getDirectionToFood(foodField);
+    } else {
+        agent.getDirectionToFood(foodIndex);
+    }
+}
+
+int EvolutionSimulation::evaluateInArenas(ThreadPool& pool, int arenaCount) {
+    arenaCount = max(1, min(arenaCount, (int)population.size()));
+
+    // Арены живут между поколениями, чтобы их буферы (поле, индекс еды, пакет вывода) не выделялись заново
+    if ((int)arenas.size() != arenaCount) {
+        // Копия поля только со стенами - основа для всех арен
+        Grid walls = grid;
+        walls.clear();
+        walls.clearDirty();
+
+        arenas.clear();
+        for (int a = 0; a < arenaCount; a++) {
+            arenas.push_back(make_unique<EvolutionSimulation>(walls, 0, 0));
+        }
+        arenaMembers.assign(arenaCount, {});
+        arenaTicks.assign(arenaCount, 0);
+    }
+
+    for (int a = 0; a < arenaCount; a++) {
+        // Захват не больше двух слов, чтобы задача поместилась в function без выделения памяти
+        pool.submit([this, a] {
+            int arenaCount = arenas.size();
+            // Поток арены зависит от поколения и номера арены, но не от потока пула
+            uint64_t arenaStream = mixStream(stream, mixStream(generation, a + 1));
+            EvolutionSimulation& arena = *arenas[a];
+            vector<pair<int, int>>& members = arenaMembers[a]; // (номер агента в популяции, номер его копии в арене)
+            members.clear();
+            arena.resetArena(arenaStream);
+
+            // Агенты распределяются по аренам по кругу
+            for (int i = a; i < population.size(); i += arenaCount) {
+                int x, y;
+                if (arena.findRandomEmptyPosition(x, y)) {
+                    int copy = arena.addAgent(x, y, InitEnergyAgent, population.gene(i));
+                    members.push_back({i, copy});
+                }
+            }
+            arena.totalAlives = members.size();
+
+            int step = 1;
+            for (; step <= NumberOfSteps; step++) {
+                if (!arena.simulateStep()) { break; }
+            }
+            arenaTicks[a] = step - 1;
+
+            // Каждая задача пишет только в своих агентов
+            const AgentStore& result = arena.population;
+            for (auto [agent, copy] : members) {
+                population.energy[agent] = result.energy[copy];
+                population.steps[agent] = result.steps[copy];
+                population.alive[agent] = result.alive[copy];
+            }
+        });
+    }
+
+    pool.wait();
+
+    // Сводим результаты арен
+    fitnessReady = false;
+    totalAlives = count(population.alive.begin(), population.alive.end(), 1);
+    totalDeaths = population.size() - totalAlives;
+    recountEnergy();
+
+    return accumulate(arenaTicks.begin(), arenaTicks.end(), 0);
+}
+
+void EvolutionSimulation::resetArena(uint64_t arenaStream) {
+    // То же состояние, что у новой симуляции EvolutionSimulation(walls, 0, InitFoodCount, arenaStream)
+    stream = arenaStream;
+    rng = Random(getGlobalSeed(), arenaStream);
+
+    population.clear();
+    grid.clear();
+    grid.clearDirty();
+    foodIndex.clear();
+    vacatedCells.clear();
+    FoodValue.clear();
+
+    totalDeaths = 0;
+    totalAlives = 0;
+    currentTick = 0;
+    recountEnergy();
+
+    initializeFood(InitFoodCount);
+}
+
+void EvolutionSimulation::updateFitness() {
+    if (fitnessReady) {
+        return;
+    }
+
+    fitness.resize(population.size());
+    for (int i = 0; i < population.size(); i++) {
+        fitness[i] = population.steps[i] * 0.2f + population.energy[i] * 0.8f;
+    }
+    fitnessReady = true;
+}
+
+void EvolutionSimulation::sortPop(int bestCount, int worstCount) {
+    int size = population.size();
+    updateFitness();
+
+    // Равные по приспособленности агенты упорядочиваются по номеру, чтобы порядок не зависел от реализации std
+    auto fitter = [this](int a, int b) {
+        return fitness[a] > fitness[b] || (fitness[a] == fitness[b] && a < b);
+    };
+
+    int half = size / 2;
+    bestCount = min(max(bestCount, 2), half);
+    worstCount = min(max(worstCount, 0), size - half);
+
+    ranking.resize(size);
+    iota(ranking.begin(), ranking.end(), 0);
+    nth_element(ranking.begin(), ranking.begin() + half, ranking.end(), fitter);
+    if (worstCount > 0) {
+        nth_element(ranking.begin() + half, ranking.end() - worstCount, ranking.end(), fitter);
+    }
+    partial_sort(ranking.begin(), ranking.begin() + bestCount, ranking.begin() + half, fitter);
+
+    // Одним проходом переставляем массивы хранилища и приспособленность
+    population.permute(ranking);
+    rankedFitness.resize(size);
+    for (int i = 0; i < size; i++) {
+        rankedFitness[i] = fitness[ranking[i]];
+    }
+    fitness.swap(rankedFitness);
+}
 
+vector<unique_ptr<Gene>> EvolutionSimulation::cloneBestGenes(int count) const {
+    vector<unique_ptr<Gene>> genes;
+    count = min(count, (int)population.size());
+
+    for (int i = 0; i < count; i++) {
+        genes.push_back(population.gene(i).clone());
+    }
+
+    return genes;
+}
+
+void EvolutionSimulation::replaceWorstGenes(vector<unique_ptr<Gene>>& genes) {
+    int count = min((int)genes.size(), (int)population.size() - 2);
+
+    for (int i = 0; i < count; i++) {
+        population[population.size() - 1 - i].setGene(move(genes[i]));
+    }
+}
+
+void EvolutionSimulation::geneticAlgorithm() {
+    // Новое поколение собирается во втором буфере: его массивы и гены остались от позапрошлого поколения
+    AgentStore& newPop = nextPopulation;
+    newPop.clear();
+    newPop.reserve(population.size());
     // 1. СОХРАНЯЕМ ЛУЧШИХ АГЕНТОВ
-    newPop.push_back(population[0]->clone()); // 1
-    newPop.push_back(population[1]->clone()); // 2
+    population[0].clone(newPop, rng.split()); // 1
+    population[1].clone(newPop, rng.split()); // 2
 
     // // 2. ФОРМИРУЕМ ТОП ЛУЧШИХ И ХУДШИХ
     // vector<unique_ptr<Agent>> goodPop;
     // vector<unique_ptr<Agent>> badPop;
 
     // 3. СКРЕЩИВАЕМ ПЕРВУЮ ПОЛОВИНУ
+    // Родители выбираются среди всех, кроме элиты, по приспособленности за прошедший раунд
+    updateFitness();
+    selection.prepare(getSelectionSettings(), fitness, 2, population.size() - 1);
     for (int i = 2; i < population.size() / 2; i++) {
-        int parent1 = randomAg(rng);
-        int parent2 = randomAg(rng);
+        int parent1 = selection.select(rng);
+        int parent2 = selection.select(rng);
         
-        auto newAgent = population[parent1]->clone();
+        Agent newAgent = population[parent1].clone(newPop, rng.split());
         
-        if (random(rng) < AGENT_CHANCE_TO_CROSS_OVER) {
-            newAgent->crossing(*population[i+1]);
+        if (rng.uniform(0.0f, 1.0f) < AgentChanceToCrossOver) {
+            newAgent.crossing(population[i+1]);
         }
-        if (random(rng) < AGENT_MUTATION_CHANCE * 0.33f) {
-            newAgent->mutateGene(mutationPower);
+        if (rng.uniform(0.0f, 1.0f) < AgentMutationChance * 0.33f) {
+            newAgent.mutateGene(mutationPower);
         }
-
-        newPop.push_back(move(newAgent));
     }
 
     // 4. ПРИМЕНЯЕМ МУТАЦИИ КО ВТОРОЙ ПОЛОВИНЕ
     for (int i = population.size() / 2; i < population.size(); i++) {
-        newPop.push_back(population[i]->clone());
+        Agent newAgent = population[i].clone(newPop, rng.split());
 
-        if (random(rng) < AGENT_MUTATION_CHANCE) {
-            newPop[i]->mutateGene(mutationPower);
+        if (rng.uniform(0.0f, 1.0f) < AgentMutationChance) {
+            newAgent.mutateGene(mutationPower);
         }
     }
+    swap(population, nextPopulation);
+    fitnessReady = false;
         
     // Адаптивная регулировка силы мутации
-    if (getSimulationData().averageEnergyLevel > INIT_ENERGY_AGENT * 2 * 1.2f) {
+    if (getSimulationData().averageEnergyLevel > InitEnergyAgent * 2 * 1.2f) {
         // Успешный агент - уменьшаем мутацию
         mutationPower = max(0.0005f, mutationPower * 0.6f);
     } else {
@@ -223,142 +416,103 @@ void EvolutionSimulation::geneticAlgorithm() {
     generation++;
 }
 
-void EvolutionSimulation::spawnNewFood(uniform_int_distribution<int> foodV) {
-    // Добавляем новую еду с вероятностью CHANCE_OF_FOOD_APPEARANCE%
-    uniform_real_distribution<float> chance(0.0f, 1.0f);
-
-    if (chance(rng) < CHANCE_OF_FOOD_APPEARANCE) {
+void EvolutionSimulation::spawnNewFood(float chance) {
+    // Добавляем новую еду с вероятностью ChanceOfFoodAppearance%
+    if (chance < ChanceOfFoodAppearance) {
         int x, y;
         if (findRandomEmptyPosition(x, y)) {
-            addFood(x, y, FoodValue[foodV(rng)]);
+            addFood(x, y, rng.uniformInt((int)(EnergyFoodValue / 3), (int)EnergyFoodValue));
         }
     }
 }
 
 void EvolutionSimulation::updateGrid() {
-    // Обновляем тип клеток
-    for (auto& row : grid) {
-        for (auto& cell : row) {
-            if (cell.type != WALL && cell.type != FOOD) {
-                cell.type = EMPTY;
-            }
-        }
-    }
-    
-    // Размещаем агентов на поле
-    for (auto& agent : population) {
-        if (agent->getIsAlive()) {
-            grid[agent->getX()][agent->getY()].type = AGENT;
-        }
+    // Новые клетки агентов уже отмечены при ходе, осталось освободить покинутые
+    for (int cell : vacatedCells) {
+        grid.setType(cell, EMPTY);
     }
+    vacatedCells.clear();
 }
 
-unique_ptr<NeuralNetwork> EvolutionSimulation::createNetw(const ProgramParameters& param) {
-    auto neuralNet = make_unique<NeuralNetwork>();
-    
-    auto layer1 = make_unique<GeneLayer>(param.InputValues, param.NeuronsInHiddenLayer, param.activationMid);
-    
-    const auto& weights1 = param.weights[0];
-    vector<vector<float>> layer1_w(param.InputValues, vector<float>(param.NeuronsInHiddenLayer));
-    
-    for (int i = 0; i < param.InputValues; i++) {
-        for (int o = 0; o < param.NeuronsInHiddenLayer; o++) {
-            int indx = i * param.NeuronsInHiddenLayer + o;
-            layer1_w[i][o] = weights1[indx];
-        }
-    }
-    layer1->setWeights(layer1_w);
-    
-    // Устанавливаем смещения для среднего слоя
-    layer1->setBiases(param.biases[0]);
-    
-    neuralNet->addLayer(move(layer1));
+void EvolutionSimulation::tuneSimWithTrainedAgents(const Grid& field, const NeuralNetwork& network) {
+    // Копия обученной сети
+    auto neuralNet = network.clone();
     
-    auto layer2 = make_unique<GeneLayer>(param.NeuronsInHiddenLayer, param.OutputValues, param.activationLast);
-    
-    // Устанавливаем веса для второго слоя
-    const auto& weights2 = param.weights[1];
-    vector<vector<float>> layer2_w(param.NeuronsInHiddenLayer, vector<float>(param.OutputValues));
-    
-    // Преобразуем плоский вектор в матрицу [hidden_size][output_size]
-    for (int i = 0; i < param.NeuronsInHiddenLayer; i++) {
-        for (int o = 0; o < param.OutputValues; o++) {
-            int indx = i * param.OutputValues + o;
-            layer2_w[i][o] = weights2[indx];
-        }
-    }
-    layer2->setWeights(layer2_w);
-    
-    // Устанавливаем смещения для последнего слоя
-    layer2->setBiases(param.biases[1]);
-    
-    neuralNet->addLayer(move(layer2));
-    
-    return neuralNet;
-}
-
-void EvolutionSimulation::tuneSimWithTrainedAgents(vector<vector<Cell>> field, const ProgramParameters& param) {
-    // Создаем одну нейросеть
-    auto neuralNet = createNetw(param);
-    
-    // Создаем NeuralGene с этой нейросетью
-    auto newNeuralGene = make_unique<NeuralGene>(move(neuralNet));
+    // Создаем ген с этой нейросетью (специализированный, если топология стандартная)
+    auto newNeuralGene = createGene(move(neuralNet));
     
     // Создаем агентов с одной нейросетью
-    for (int i = 0; i < INIT_POP_SIZE; i++) {
+    for (int i = 0; i < InitPopSize; i++) {
         int x, y;
         if (findRandomEmptyPosition(x, y)) {
-            addAgent(x, y, INIT_ENERGY_AGENT, newNeuralGene->clone());
+            addAgent(x, y, InitEnergyAgent, newNeuralGene->clone());
         }
     }
     
     updateGrid();
 }
 
-Agent* EvolutionSimulation::addAgent(int x, int y, int energy, unique_ptr<Gene> genome) {
-    if ((x < 0 || x >= grid.size()) || (y < 0 || y >= grid[0].size())) {
-        return nullptr;
+int EvolutionSimulation::addAgent(int x, int y, int energy, unique_ptr<Gene> genome) {
+    if (!grid.inBounds(x, y)) {
+        return -1;
     }
     
-    if (grid[x][y].type != EMPTY) {
-        return nullptr;
+    if (grid.getType(x, y) != EMPTY) {
+        return -1;
     }
     
     // Создаем агента
-    auto agent = make_unique<Agent>(x, y, energy, std::move(genome));
-    Agent* agent_ptr = agent.get();
-    population.push_back(move(agent));
+    int index = population.add(x, y, energy, std::move(genome), rng.split());
+    placeAgent(x, y, energy);
     
+    return index;
+}
+
+int EvolutionSimulation::addAgent(int x, int y, int energy, const Gene& genome) {
+    if (!grid.inBounds(x, y) || grid.getType(x, y) != EMPTY) {
+        return -1;
+    }
+
+    int index = population.addCopy(x, y, energy, genome, rng.split());
+    placeAgent(x, y, energy);
+
+    return index;
+}
+
+void EvolutionSimulation::placeAgent(int x, int y, int energy) {
     // Обновляем клетку
-    grid[x][y].type = AGENT;
-    
-    return agent_ptr;
+    grid.setType(x, y, AGENT);
+
+    // Учитываем энергию нового агента
+    energyTotal += energy;
+    energyMin = energyAgents ? min(energyMin, energy) : energy;
+    energyMax = energyAgents ? max(energyMax, energy) : energy;
+    energyAgents++;
 }
 
 bool EvolutionSimulation::addFood(int x, int y, int energyValue) {
-    if ((x < 0 || x >= grid.size()) || (y < 0 || y >= grid[0].size())) {
+    if (!grid.inBounds(x, y)) {
         return false;
     }
     
-    if (grid[x][y].type != EMPTY) {
+    if (grid.getType(x, y) != EMPTY) {
         return false;
     }
     
-    grid[x][y].type = FOOD;
-    grid[x][y].foodValue = energyValue;
+    grid.setType(x, y, FOOD);
+    grid.setFoodValue(x, y, energyValue);
+    foodIndex.add(x, y);
 
     return true;
 }
 
-const Cell& EvolutionSimulation::getCell(int x, int y) const
+Cell EvolutionSimulation::getCell(int x, int y) const
 {
-    static Cell invalidCell{WALL}; // Возвращаем стену для невалидных координат
-    
-    if ((x >= 0 && x < grid.size()) && (y >= 0 && y < grid[0].size())) {
-        return grid[x][y];
+    if (grid.inBounds(x, y)) {
+        return grid.getCell(x, y);
     }
     
-    return invalidCell;
+    return {WALL, 0}; // Возвращаем стену для невалидных координат
 }
 
 EvolutionSimulation::SimulationData EvolutionSimulation::getSimulationData() const {
@@ -368,88 +522,67 @@ EvolutionSimulation::SimulationData EvolutionSimulation::getSimulationData() con
     data.mutationPower = mutationPower;
     data.totalAlives = totalAlives;
     data.totalDeaths = totalDeaths;
-    int alive = 0;
+    data.totalFood = grid.getCount(FOOD); // Количество именно клеток еды (пока-что энергетическая ценность для всех одинакова)
+    data.averageEnergyLevel = energyAgents ? (int)(energyTotal / energyAgents) : 0;
+    data.minEnergyLevel = energyMin;
+    data.maxEnergyLevel = energyMax;
     
-    // Считаем статистику по еде
-    data.totalFood = 0;
-    for (const auto& row : grid) {
-        for (const auto& cell : row) {
-            if (cell.type == FOOD) {
-                data.totalFood++; // Количество именно клеток еды (пока-что энергетическая ценность для всех одинакова)
-            }
+    return data;
+}
+
+void EvolutionSimulation::recountEnergy() {
+    energyTotal = 0;
+    energyMin = INT_MAX;
+    energyMax = INT_MIN;
+    energyAgents = 0;
+    
+    for (int i = 0; i < population.size(); i++) {
+        if (population.alive[i]) {
+            int energy = population.energy[i];
+            energyTotal += energy;
+            energyMin = min(energyMin, energy);
+            energyMax = max(energyMax, energy);
+            energyAgents++;
         }
     }
-    
-    // Считаем статистику по энергии агентов
-    if (!population.empty()) {
-        int totalEnergy = 0;
-        data.minEnergyLevel = INT_MAX;
-        data.maxEnergyLevel = INT_MIN;
-        
-        for (const auto& agent : population) {
-            if (agent->getIsAlive()) {
-                int energy = agent->getEnergy();
-                alive++;
-
-                totalEnergy += energy;
-                data.minEnergyLevel = min(data.minEnergyLevel, energy);
-                data.maxEnergyLevel = max(data.maxEnergyLevel, energy);
-            }
-        }
 
-        if (alive != 0) {
-            data.averageEnergyLevel = totalEnergy / alive;
-        } else {
-            data.averageEnergyLevel = 0;
-            data.minEnergyLevel = 0;
-            data.maxEnergyLevel = 0;
-        }
-    } else {
-        data.averageEnergyLevel = 0;
-        data.minEnergyLevel = 0;
-        data.maxEnergyLevel = 0;
+    if (energyAgents == 0) {
+        energyMin = 0;
+        energyMax = 0;
     }
-    
-    return data;
 }
 
 void EvolutionSimulation::reloadGrid() {
-    for (auto& row : grid) {
-        for (auto& cell : row) {
-            if (cell.type != WALL) {
-                cell.type = EMPTY;
-                cell.foodValue = 0;
-            }
-        }
-    }
+    fitnessReady = false;
+    grid.clear();
+    foodIndex.clear();
+    vacatedCells.clear();
+
+    fill(population.energy.begin(), population.energy.end(), InitEnergyAgent);
+    fill(population.alive.begin(), population.alive.end(), 1);
+    fill(population.steps.begin(), population.steps.end(), 0);
 
-    for (auto& agent : population) {
+    for (int i = 0; i < population.size(); i++) {
         int x, y;
-        agent->setEnergy(INIT_ENERGY_AGENT);
-        agent->setIsAlive(true);
-        agent->setSteps(0);
         findRandomEmptyPosition(x, y);
-        agent->setX(x);
-        agent->setY(y);
+        population.x[i] = x;
+        population.y[i] = y;
+        grid.setType(x, y, AGENT); // Занимаем клетку сразу, чтобы туда не попали другие агенты и еда
     }
 
     totalDeaths = 0;
-    totalAlives = INIT_POP_SIZE;
+    totalAlives = InitPopSize;
     currentTick = 0;
 
-    initializeFood(INIT_FOOD_COUNT);
+    initializeFood(InitFoodCount);
     updateGrid();
+    recountEnergy();
 }
 
 void EvolutionSimulation::resetSim() {
-    for (auto& row : grid) {
-        for (auto& cell : row) {
-            if (cell.type != WALL) {
-                cell.type = EMPTY;
-                cell.foodValue = 0;
-            }
-        }
-    }
+    grid.clear();
+    foodIndex.clear();
+    vacatedCells.clear();
     
     population.clear();
     totalDeaths = 0;
@@ -457,7 +590,7 @@ void EvolutionSimulation::resetSim() {
     currentTick = 0;
     generation = 0;
     
-    // generateFixedFood(INIT_FOOD_COUNT);
-    initializePopulation(INIT_POP_SIZE);
-    initializeFood(INIT_FOOD_COUNT);
+    // generateFixedFood(InitFoodCount);
+    initializePopulation(InitPopSize);
+    initializeFood(InitFoodCount);
 }
\ No newline at end of file
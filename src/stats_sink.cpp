@@ -0,0 +1,360 @@
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include "stats_sink.h"
+#include "genome_file.h"
+#include "mapped_file.h"
+
+using namespace std;
+
+static const char FILE_MAGIC[4] = {'A', 'G', 'S', 'T'};
+static const char BLOCK_MAGIC[4] = {'S', 'B', 'L', 'K'};
+static const uint32_t FORMAT_VERSION = 1;
+static const uint32_t FLAG_ISLANDS = 1;
+static const size_t ROW_BYTES = 2 * sizeof(uint16_t) + 3 * sizeof(int32_t);
+
+struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t reserved[2];
+};
+
+struct BlockHeader {
+    char magic[4];
+    uint32_t rowCount;
+    int32_t firstGeneration;
+    uint32_t flags;
+    uint32_t reserved[2];
+    uint64_t checksum;       // FNV-1a по столбцам блока
+};
+
+static_assert(sizeof(FileHeader) == 16, "stats file header must be 16 bytes");
+static_assert(sizeof(BlockHeader) == 32, "stats block header must be 32 bytes");
+
+/**
+ * @brief Проверяет блок в начале буфера.
+ * @param header Заполняется заголовком блока.
+ * @return Размер блока, 0 если блок поврежден или не помещается в буфер.
+ */
+static size_t parseBlock(const unsigned char* bytes, size_t available, BlockHeader& header) {
+    if (available < sizeof(header)) {
+        return 0;
+    }
+    memcpy(&header, bytes, sizeof(header));
+
+    if (memcmp(header.magic, BLOCK_MAGIC, 4) != 0 || header.rowCount == 0
+        || header.rowCount > (available - sizeof(header)) / ROW_BYTES) {
+        return 0;
+    }
+
+    size_t columnBytes = header.rowCount * ROW_BYTES;
+    if (fnv1a(bytes + sizeof(header), columnBytes) != header.checksum) {
+        return 0;
+    }
+    return sizeof(header) + columnBytes;
+}
+
+template <class T>
+static void storeColumn(unsigned char*& out, T value) {
+    memcpy(out, &value, sizeof(value));
+    out += sizeof(value);
+}
+
+template <class T>
+static T loadColumn(const unsigned char* column, size_t row) {
+    T value;
+    memcpy(&value, column + row * sizeof(T), sizeof(value));
+    return value;
+}
+
+/**
+ * @brief Дописывает в rows строки проверенного блока.
+ * @param block Начало блока (заголовок).
+ */
+static void readBlockRows(const unsigned char* block, const BlockHeader& header, vector<StatsRow>& rows) {
+    size_t count = header.rowCount;
+    const unsigned char* islandColumn = block + sizeof(header);
+    const unsigned char* deltaColumn = islandColumn + count * sizeof(uint16_t);
+    const unsigned char* energyColumn = deltaColumn + count * sizeof(int16_t);
+    const unsigned char* stepsColumn = energyColumn + count * sizeof(int32_t);
+    const unsigned char* aliveColumn = stepsColumn + count * sizeof(int32_t);
+
+    int generation = header.firstGeneration;
+    for (size_t i = 0; i < count; i++) {
+        generation += loadColumn<int16_t>(deltaColumn, i);
+        rows.push_back({loadColumn<uint16_t>(islandColumn, i), generation, loadColumn<int32_t>(energyColumn, i),
+                        loadColumn<int32_t>(stepsColumn, i), loadColumn<int32_t>(aliveColumn, i)});
+    }
+}
+
+StatsSink::StatsSink() : islands(false), flushInterval(0), busy(false), flushRequested(false), stopping(false) {}
+
+StatsSink::~StatsSink() {
+    close();
+}
+
+bool StatsSink::open(const string& path, bool newIslands, int newFlushInterval, int resumeGeneration) {
+    close();
+    islands = newIslands;
+    flushInterval = newFlushInterval;
+
+    error_code error;
+    uintmax_t existing = filesystem::exists(path, error) ? filesystem::file_size(path, error) : 0;
+    if (error) {
+        existing = 0;
+    }
+
+    if (existing >= sizeof(FileHeader)) {
+        size_t valid = 0;
+        vector<StatsRow> kept; // Начало последнего блока, если он обрезается посередине
+        {
+            MappedFile input;
+            FileHeader header;
+            if (!input.open(path, sizeof(header))) {
+                cerr << "Cannot open statistics file: " << path << "\n";
+                return false;
+            }
+            memcpy(&header, input.getData(), sizeof(header));
+            if (memcmp(header.magic, FILE_MAGIC, 4) != 0 || header.version != FORMAT_VERSION) {
+                cerr << "Not a statistics file: " << path << "\n";
+                return false;
+            }
+
+            valid = sizeof(header);
+            vector<size_t> blocks;
+            BlockHeader block;
+            while (size_t blockSize = parseBlock(input.getData() + valid, input.getSize() - valid, block)) {
+                blocks.push_back(valid);
+                valid += blockSize;
+            }
+
+            // Строки, записанные после контрольной точки прерванного запуска, лежат в конце журнала
+            // и будут записаны заново - отрезаем их с конца до первой строки раньше resumeGeneration
+            while (resumeGeneration > 0 && !blocks.empty()) {
+                const unsigned char* start = input.getData() + blocks.back();
+                parseBlock(start, input.getSize() - blocks.back(), block);
+                kept.clear();
+                readBlockRows(start, block, kept);
+
+                size_t count = kept.size();
+                while (!kept.empty() && kept.back().generation >= resumeGeneration) {
+                    kept.pop_back();
+                }
+                if (kept.size() == count) {
+                    kept.clear();
+                    break;
+                }
+
+                valid = blocks.back();
+                blocks.pop_back();
+                if (!kept.empty()) {
+                    break;
+                }
+            }
+        }
+
+        // Отрезаем недописанный хвост (и отброшенные строки), чтобы новые блоки шли сразу за последним целым
+        if (valid < existing) {
+            filesystem::resize_file(path, valid, error);
+            if (error) {
+                cerr << "Cannot repair statistics file: " << path << "\n";
+                return false;
+            }
+        }
+        file.open(path, ios::binary | ios::app);
+        if (!kept.empty()) {
+            writeRows(kept); // Фоновый поток еще не запущен
+        }
+    } else {
+        file.open(path, ios::binary | ios::trunc);
+        FileHeader header{};
+        memcpy(header.magic, FILE_MAGIC, 4);
+        header.version = FORMAT_VERSION;
+        file.write((const char*)&header, sizeof(header));
+        file.flush();
+    }
+
+    if (!file.good()) {
+        file.close();
+        return false;
+    }
+
+    stopping = false;
+    worker = thread(&StatsSink::run, this);
+    return true;
+}
+
+void StatsSink::add(const StatsRow& row) {
+    {
+        lock_guard<mutex> guard(lock);
+        if (!worker.joinable()) {
+            return;
+        }
+        rows.push_back(row);
+    }
+    if (flushInterval == 0) {
+        changed.notify_all();
+    }
+}
+
+void StatsSink::flush() {
+    unique_lock<mutex> guard(lock);
+    if (!worker.joinable()) {
+        return;
+    }
+    flushRequested = true;
+    changed.notify_all();
+    changed.wait(guard, [this] { return rows.empty() && !busy; });
+}
+
+void StatsSink::close() {
+    if (worker.joinable()) {
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        changed.notify_all();
+        worker.join(); // Поток допишет оставшиеся строки перед выходом
+    }
+    file.close();
+}
+
+void StatsSink::run() {
+    unique_lock<mutex> guard(lock);
+    auto ready = [this] { return stopping || flushRequested || (flushInterval == 0 && !rows.empty()); };
+
+    while (true) {
+        if (flushInterval > 0) {
+            changed.wait_for(guard, chrono::milliseconds(flushInterval), ready);
+        } else {
+            changed.wait(guard, ready);
+        }
+
+        if (!rows.empty()) {
+            swap(rows, writing);
+            busy = true;
+            guard.unlock();
+
+            writeRows(writing);
+            writing.clear();
+
+            guard.lock();
+            busy = false;
+        }
+        if (rows.empty()) {
+            flushRequested = false;
+            changed.notify_all();
+            if (stopping) {
+                return;
+            }
+        }
+    }
+}
+
+void StatsSink::writeRows(const vector<StatsRow>& batch) {
+    buffer.clear();
+
+    size_t start = 0;
+    while (start < batch.size()) {
+        // Блок обрывается, если приращение поколения не помещается в int16
+        size_t end = start + 1;
+        while (end < batch.size()) {
+            int delta = batch[end].generation - batch[end - 1].generation;
+            if (delta < INT16_MIN || delta > INT16_MAX) {
+                break;
+            }
+            end++;
+        }
+
+        size_t count = end - start;
+        size_t offset = buffer.size();
+        buffer.resize(offset + sizeof(BlockHeader) + count * ROW_BYTES);
+        unsigned char* columns = buffer.data() + offset + sizeof(BlockHeader);
+
+        unsigned char* out = columns;
+        for (size_t i = start; i < end; i++) {
+            storeColumn<uint16_t>(out, (uint16_t)batch[i].island);
+        }
+        for (size_t i = start; i < end; i++) {
+            storeColumn<int16_t>(out, (int16_t)(i == start ? 0 : batch[i].generation - batch[i - 1].generation));
+        }
+        for (size_t i = start; i < end; i++) {
+            storeColumn<int32_t>(out, batch[i].averageEnergy);
+        }
+        for (size_t i = start; i < end; i++) {
+            storeColumn<int32_t>(out, batch[i].topSteps);
+        }
+        for (size_t i = start; i < end; i++) {
+            storeColumn<int32_t>(out, batch[i].aliveAgents);
+        }
+
+        BlockHeader header{};
+        memcpy(header.magic, BLOCK_MAGIC, 4);
+        header.rowCount = count;
+        header.firstGeneration = batch[start].generation;
+        header.flags = islands ? FLAG_ISLANDS : 0;
+        header.checksum = fnv1a(columns, count * ROW_BYTES);
+        memcpy(buffer.data() + offset, &header, sizeof(header));
+
+        start = end;
+    }
+
+    file.write((const char*)buffer.data(), buffer.size());
+    file.flush();
+    if (!file.good()) {
+        cerr << "Cannot write statistics\n";
+        file.clear();
+    }
+}
+
+int exportStatsToCsv(const string& statsPath, const string& csvPath) {
+    MappedFile input;
+    FileHeader header;
+    if (!input.open(statsPath, sizeof(header))) {
+        cerr << "Cannot open statistics file: " << statsPath << "\n";
+        return -1;
+    }
+    memcpy(&header, input.getData(), sizeof(header));
+    if (memcmp(header.magic, FILE_MAGIC, 4) != 0 || header.version != FORMAT_VERSION) {
+        cerr << "Not a statistics file: " << statsPath << "\n";
+        return -1;
+    }
+
+    const unsigned char* data = input.getData();
+    size_t size = input.getSize();
+    BlockHeader block;
+
+    // Первый проход только по заголовкам: нужен ли столбец острова
+    bool islands = false;
+    for (size_t offset = sizeof(header); size_t blockSize = parseBlock(data + offset, size - offset, block); offset += blockSize) {
+        islands = islands || (block.flags & FLAG_ISLANDS);
+    }
+
+    ofstream output(csvPath);
+    if (!output.is_open()) {
+        cerr << "Cannot create CSV file: " << csvPath << "\n";
+        return -1;
+    }
+    output << (islands ? "Island;" : "") << "Generation;AvgEnergy;TopSteps;AliveAgents\n";
+
+    int exported = 0;
+    vector<StatsRow> rows;
+    for (size_t offset = sizeof(header); size_t blockSize = parseBlock(data + offset, size - offset, block); offset += blockSize) {
+        rows.clear();
+        readBlockRows(data + offset, block, rows);
+        for (const StatsRow& row : rows) {
+            if (islands) {
+                output << row.island << ";";
+            }
+            output << row.generation << ";" << row.averageEnergy << ";" << row.topSteps << ";" << row.aliveAgents << "\n";
+        }
+        exported += rows.size();
+    }
+
+    if (!output.good()) {
+        cerr << "Cannot write CSV file: " << csvPath << "\n";
+        return -1;
+    }
+    return exported;
+}
@@ -1,33 +1,141 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
+#include <thread>
 #include <vector>
-#include <iomanip>
-#include <sstream>
 #include "streamout.h"
+#include "triple_buffer.h"
+
+#ifdef _WIN32
+    #include <io.h>
+#else
+    #include <cerrno>
+    #include <unistd.h>
+#endif
 
 using namespace std;
 
-static vector<vector<Cell>> previousField; // Буфер состояния поля
-static vector<vector<char>> previousTable; // Буфер таблицы
-vector<vector<char>> table;                // Таблица статистики
-
-vector<vector<Cell>> createField(int width, int height) {
-    // Инициализируем буферы
-    previousField = vector<vector<Cell>>(height + 2, vector<Cell>(width + 2, {EMPTY}));
-    previousTable = vector<vector<char>>(5, vector<char>(width + 2, ' '));
-    table = vector<vector<char>>(5, vector<char>(width + 50, ' '));
-    
-    auto field = vector<vector<Cell>>(height + 2, vector<Cell>(width + 2, {EMPTY}));
-
-    // Задаем стены на границах
-    for (int i = 0; i < width + 2; i++) {
-        field[0][i].type = WALL;          // Верхняя граница
-        field[height + 1][i].type = WALL; // Нижняя граница
+static const int TABLE_ROWS = 5;     // Строк в таблице статистики
+static const int TABLE_EXTRA = 48;   // Таблица шире поля со стенами на столько символов
+static const int MAX_GAP = 8;        // Совпадающих символов, которые дешевле переписать, чем переместить каретку
+
+static const char SYMBOLS[4] = {SYMBOL_EMPTY, SYMBOL_FOOD, SYMBOL_WALL, SYMBOL_AGENT}; // По CellType
+
+static FrameRenderer frame;          // Поле и таблица под ним
+
+/**
+ * @brief Снимок для потока отрисовки: поле и статистика на момент публикации.
+ */
+struct FrameSnapshot {
+    vector<uint8_t> types;                     // Плоскость типов клеток
+    int width = 0;                             // Ширина поля со стенами
+    EvolutionSimulation::SimulationData data;  // Статистика симуляции
+    int generation = 0;                        // Параметры таблицы (см. updateTable)
+    int skipGen = 0;
+    int currentStep = 0;
+    int totalSteps = 0;
+};
+
+static TripleBuffer<FrameSnapshot> snapshots; // Снимки от симуляции к потоку отрисовки
+static thread renderThread;
+static atomic<bool> renderStop{false};
+static bool renderThreadActive = false;       // Меняется только потоком симуляции
+
+FrameRenderer::FrameRenderer() : width(0), height(0) {}
+
+void FrameRenderer::resize(int newWidth, int newHeight) {
+    width = newWidth;
+    height = newHeight;
+    current.assign(width * height, ' ');
+    previous.assign(width * height, ' ');
+    marked.assign(height, 0);
+    lastMarked.assign(height, 0);
+
+    // С запасом на перемещения каретки: кадр не должен перевыделять буфер
+    output.clear();
+    output.reserve((size_t)(width * 3 + 16) * height + 32);
+}
+
+void FrameRenderer::beginFrame() {
+    for (int y = 0; y < height; y++) {
+        if (lastMarked[y]) {
+            memcpy(&current[y * width], &previous[y * width], width);
+        }
     }
+}
+
+void FrameRenderer::moveCursor(int row, int column) {
+    char sequence[32];
+    int length = snprintf(sequence, sizeof(sequence), "\033[%d;%dH", row + 1, column + 1);
+    output.insert(output.end(), sequence, sequence + length);
+}
 
-    for (int j = 0; j < height + 2; j++) {
-        field[j][0].type = WALL;          // Левая граница
-        field[j][width + 1].type = WALL;  // Правая граница
+void FrameRenderer::present(int cursorRow) {
+    output.clear();
+
+    for (int y = 0; y < height; y++) {
+        if (!marked[y]) {
+            continue;
+        }
+
+        const char* now = &current[y * width];
+        const char* shown = &previous[y * width];
+        int x = 0;
+        while (x < width) {
+            if (now[x] == shown[x]) {
+                x++;
+                continue;
+            }
+
+            // Участок продолжается, пока промежутки совпадающих символов короче MAX_GAP
+            int start = x;
+            int end = x + 1;
+            for (int k = end; k < width && k - end < MAX_GAP; k++) {
+                if (now[k] != shown[k]) {
+                    end = k + 1;
+                }
+            }
+
+            moveCursor(y, start);
+            output.insert(output.end(), now + start, now + end);
+            x = end;
+        }
     }
+    moveCursor(cursorRow, 0);
+
+    // Все, что уже лежит в буферах потоков вывода, должно попасть на экран раньше кадра
+    cout.flush();
+    fflush(stdout);
+
+    size_t written = 0;
+    while (written < output.size()) {
+#ifdef _WIN32
+        int done = _write(_fileno(stdout), output.data() + written, (unsigned)(output.size() - written));
+#else
+        ssize_t done = ::write(STDOUT_FILENO, output.data() + written, output.size() - written);
+        if (done < 0 && errno == EINTR) {
+            continue;
+        }
+#endif
+        if (done <= 0) {
+            break;
+        }
+        written += done;
+    }
+
+    swap(current, previous);
+    swap(marked, lastMarked);
+    fill(marked.begin(), marked.end(), 0);
+}
+
+Grid createField(int width, int height) {
+    // Кадр: поле со стенами и таблица под ним
+    frame.resize(width + 2 + TABLE_EXTRA, height + 2 + TABLE_ROWS);
+
+    Grid field(width, height); // Стены задаются на границах
 
     #ifdef _WIN32
         system("cls");
@@ -40,76 +148,133 @@ vector<vector<Cell>> createField(int width, int height) {
     return field;
 }
 
-void updateTable(const EvolutionSimulation& sim, int generation, int skipGen, int currentStep, int totalSteps) {
-    auto data = sim.getSimulationData();
-    
-    // Очищаем таблицу
-    for (auto& row : table) {
-        fill(row.begin(), row.end(), ' ');
+/**
+ * @brief Рисует таблицу статистики под полем.
+ */
+static void drawTable(const EvolutionSimulation::SimulationData& data, int generation, int skipGen, int currentStep, int totalSteps) {
+    // Строки статистики (форматируются без выделения памяти)
+    char lines[TABLE_ROWS][160];
+    snprintf(lines[0], sizeof(lines[0]), "|---------------------------------------------------|    ");
+    snprintf(lines[1], sizeof(lines[1]), "| Gen: %4d/%d| Food: %9d| Avg Energy: %3d|    ",
+             data.generation, generation, data.totalFood, data.averageEnergyLevel);
+    snprintf(lines[2], sizeof(lines[2]), "| Step: %6d/%d| Skip Gen: %5d| Max Energy: %3d|    ",
+             currentStep, totalSteps, skipGen, data.maxEnergyLevel);
+    snprintf(lines[3], sizeof(lines[3]), "| Agents: %5d/%d| Mut Power: %.2f| Min Energy: %3d|    ",
+             data.populationSize - data.totalDeaths, data.populationSize, data.mutationPower, data.minEnergyLevel);
+    snprintf(lines[4], sizeof(lines[4]), "|---------------------------------------------------|    ");
+
+    // Таблица стоит сразу под полем
+    int tableStartY = frame.getHeight() - TABLE_ROWS;
+    for (int i = 0; i < TABLE_ROWS; i++) {
+        char* row = frame.row(tableStartY + i);
+        int length = min((int)strlen(lines[i]), frame.getWidth());
+        memcpy(row, lines[i], length);
+        fill(row + length, row + frame.getWidth(), ' ');
     }
-    
-    // Создаем строки статистики
-    stringstream line1, line2, line3, line4, line5;
-    
-    line1 << "|---------------------------------------------------|    ";
-    line2 << "| Gen: " << setw(4) << data.generation << "/" << generation
-          << "| Food: " << setw(9) << data.totalFood
-          << "| Avg Energy: " << setw(3) << data.averageEnergyLevel << "|    ";
-    line3 << "| Step: " << setw(6) << currentStep << "/" << totalSteps
-          << "| Skip Gen: " << setw(5) << skipGen
-          << "| Max Energy: " << setw(3) << data.maxEnergyLevel << "|    ";
-    line4 << "| Agents: " << setw(5) << (data.populationSize - data.totalDeaths) << "/" << data.populationSize
-          << "| Mut Power: " << fixed << setprecision(2) << data.mutationPower
-          << "| Min Energy: " << setw(3) << data.minEnergyLevel << "|    ";
-    line5 << "|---------------------------------------------------|    ";
-    
-    string lines[] = {line1.str(), line2.str(), line3.str(), line4.str(), line5.str()};
-    
-    for (int i = 0; i < table.size(); i++) {
-        const string& line = lines[i];
-        for (int j = 0; j < line.length() && j < table[i].size(); j++) {
-            table[i][j] = line[j];
+}
+
+void updateTable(const EvolutionSimulation& sim, int generation, int skipGen, int currentStep, int totalSteps) {
+    drawTable(sim.getSimulationData(), generation, skipGen, currentStep, totalSteps);
+}
+
+/**
+ * @brief Рисует снимок целиком (в потоке отрисовки).
+ *
+ * Все строки кадра переписываются полностью, поэтому beginFrame() не нужен.
+ */
+static void drawSnapshot(const FrameSnapshot& snapshot) {
+    int rows = min((int)snapshot.types.size() / max(snapshot.width, 1), frame.getHeight() - TABLE_ROWS);
+    int columns = min(snapshot.width, frame.getWidth());
+    for (int y = 0; y < rows; y++) {
+        char* row = frame.row(y);
+        const uint8_t* types = &snapshot.types[y * snapshot.width];
+        for (int x = 0; x < columns; x++) {
+            row[x] = SYMBOLS[types[x]];
         }
     }
+
+    drawTable(snapshot.data, snapshot.generation, snapshot.skipGen, snapshot.currentStep, snapshot.totalSteps);
+    frame.present(frame.getHeight() + 2);
 }
 
-void updateField(const vector<vector<Cell>>& field, const EvolutionSimulation& sim, int generation, int skipGen, int currentStep, int totalSteps) {
-    updateTable(sim, generation, skipGen, currentStep, totalSteps);
-    
-    int fieldHeight = field.size();
-    int tableStartY = fieldHeight + 1;
-    
-    // Обновляем поле
-    for (int y = 0; y < field.size(); y++) {
-        for (int x = 0; x < field[y].size(); x++) {
-            if (field[y][x].type != previousField[y][x].type) {
-                
-                cout << "\033[" << y + 1 << ";" << x + 1 << "H"; // Перемещаем каретку
-                
-                switch (field[y][x].type) {
-                    case EMPTY: cout << SYMBOL_EMPTY; break;
-                    case WALL: cout << SYMBOL_WALL; break;
-                    case AGENT: cout << SYMBOL_AGENT; break;
-                    case FOOD: cout << SYMBOL_FOOD; break;
-                }
-            }
+static void renderLoop(int frameMs) {
+    auto nextFrame = chrono::steady_clock::now();
+    while (!renderStop.load(memory_order_acquire)) {
+        if (snapshots.consume()) {
+            drawSnapshot(snapshots.readBuffer());
         }
+
+        // Кадры идут с постоянным интервалом, отставший поток не пытается догнать пропущенные
+        nextFrame = max(nextFrame + chrono::milliseconds(frameMs), chrono::steady_clock::now());
+        this_thread::sleep_until(nextFrame);
     }
 
-    // Обновляем таблицу
-    for (int y = 0; y < table.size(); y++) {
-        for (int x = 0; x < table[y].size(); x++) {
-            if (table[y][x] != previousTable[y][x]) {
-                cout << "\033[" << tableStartY + y << ";" << x + 1 << "H"; // Перемещаем каретку под поле
-                cout << table[y][x];
-            }
-        }
+    // Последний снимок (например, итог обучения) должен остаться на экране
+    if (snapshots.consume()) {
+        drawSnapshot(snapshots.readBuffer());
     }
-    
-    cout.flush();
+}
+
+void startRenderThread(int frameMs) {
+    if (renderThreadActive || frame.getHeight() == 0) {
+        return;
+    }
+    renderStop.store(false, memory_order_relaxed);
+    renderThread = thread(renderLoop, max(frameMs, 1));
+    renderThreadActive = true;
+}
+
+void stopRenderThread() {
+    if (!renderThreadActive) {
+        return;
+    }
+    renderStop.store(true, memory_order_release);
+    renderThread.join();
+    renderThreadActive = false;
+}
+
+void updateField(const Grid& field, const EvolutionSimulation& sim, int generation, int skipGen, int currentStep, int totalSteps) {
+    updateField(field, sim.getSimulationData(), generation, skipGen, currentStep, totalSteps);
+}
+
+void updateField(const Grid& field, const EvolutionSimulation::SimulationData& data, int generation, int skipGen, int currentStep, int totalSteps) {
+    if (frame.getHeight() == 0) {
+        return; // Кадр не создан (createField не вызывался)
+    }
+
+    if (renderThreadActive) {
+        // Только снимок: копирование плоскости типов, память слотов переиспользуется
+        FrameSnapshot& snapshot = snapshots.writeBuffer();
+        snapshot.types = field.getTypes();
+        snapshot.width = field.getWidth();
+        snapshot.data = data;
+        snapshot.generation = generation;
+        snapshot.skipGen = skipGen;
+        snapshot.currentStep = currentStep;
+        snapshot.totalSteps = totalSteps;
+        snapshots.publish();
+        return;
+    }
+
+    frame.beginFrame();
 
-    previousField = field;
-    previousTable = table;
-    
-    cout << "\033[" << tableStartY + table.size() + 2 << ";1H";
-}
\ No newline at end of file
+    // Обновляем поле (только клетки, сменившие тип после прошлого кадра)
+    for (int i : field.getDirtyCells()) {
+        frame.set(i % field.getWidth(), i / field.getWidth(), SYMBOLS[field.getType(i)]);
+    }
+
+    drawTable(data, generation, skipGen, currentStep, totalSteps);
+
+    // Каретка остается ниже таблицы
+    frame.present(frame.getHeight() + 2);
+}
+
+void printField(ostream& out, const Grid& field) {
+    string line(field.getWidth(), ' ');
+    for (int y = 0; y < field.getHeight(); y++) {
+        for (int x = 0; x < field.getWidth(); x++) {
+            line[x] = SYMBOLS[field.getType(x, y)];
+        }
+        out << line << "\n";
+    }
+}
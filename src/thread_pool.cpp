@@ -0,0 +1,70 @@
+#include <algorithm>
+#include "thread_pool.h"
+
+using namespace std;
+
+ThreadPool::ThreadPool(int threadCount) : nextTask(0), pending(0), stopping(false) {
+    if (threadCount <= 0) {
+        threadCount = max(1u, thread::hardware_concurrency());
+    }
+
+    for (int i = 0; i < threadCount; i++) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    taskReady.notify_all();
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(function<void()> task) {
+    {
+        lock_guard<mutex> guard(lock);
+        tasks.push_back(move(task));
+        pending++;
+    }
+    taskReady.notify_one();
+}
+
+void ThreadPool::wait() {
+    unique_lock<mutex> guard(lock);
+    allDone.wait(guard, [this] { return pending == 0; });
+}
+
+void ThreadPool::workerLoop() {
+    while (true) {
+        function<void()> task;
+        {
+            unique_lock<mutex> guard(lock);
+            taskReady.wait(guard, [this] { return stopping || nextTask < tasks.size(); });
+
+            if (nextTask == tasks.size()) {
+                return; // Пул остановлен и задач не осталось
+            }
+
+            task = move(tasks[nextTask++]);
+            if (nextTask == tasks.size()) {
+                tasks.clear();
+                nextTask = 0;
+            }
+        }
+
+        task();
+
+        {
+            lock_guard<mutex> guard(lock);
+            pending--;
+            if (pending == 0) {
+                allDone.notify_all();
+            }
+        }
+    }
+}